@@ -0,0 +1,25 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include "../common/alloc_hooks.h"
+
+// Считает выделения за время жизни объекта и записывает в state счётчик
+// allocs_per_op (выделений на итерацию). Создаётся сразу перед циклом замера,
+// чтобы подготовка данных не попадала в счёт.
+class AllocCounter {
+  public:
+    explicit AllocCounter(benchmark::State &state) : state(state), start(allocationCount()) {}
+
+    AllocCounter(const AllocCounter &) = delete;
+    AllocCounter &operator=(const AllocCounter &) = delete;
+
+    ~AllocCounter() {
+        state.counters["allocs_per_op"] =
+            benchmark::Counter(static_cast<double>(allocationCount() - start), benchmark::Counter::kAvgIterations);
+    }
+
+  private:
+    benchmark::State &state;
+    size_t start;
+};
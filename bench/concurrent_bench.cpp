@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../include/concurrent_figures.h"
+#include "../include/figures.h"
+#include "../include/trapezoid.h"
+#include "alloc_counter.h"
+
+using FigurePtr = std::shared_ptr<Figure<double>>;
+
+// Общий набор прогретых фигур: в контейнеры попадают копии указателей
+static const std::vector<FigurePtr> &figurePool() {
+    static const std::vector<FigurePtr> pool = [] {
+        std::vector<FigurePtr> figures;
+        for (int i = 0; i < 1024; ++i) {
+            double d = i;
+            figures.push_back(std::make_shared<Trapezoid<double>>(
+                Trapezoid<double>{ {d, 0}, {d + 8, 0}, {d + 6, 4}, {d + 2, 4} }));
+            figures.back()->warmCache();
+        }
+        return figures;
+    }();
+    return pool;
+}
+
+constexpr size_t batchSize = 64;
+
+// --- Добавление из многих потоков: общий мьютекс вокруг Figures и ConcurrentFigures ---
+
+static std::unique_ptr<Figures<FigurePtr>> lockedFigures;
+static std::mutex lockedMutex;
+
+static void BM_IngestLockedFigures(benchmark::State &state) {
+    const auto &pool = figurePool();
+    if (state.thread_index() == 0)
+        lockedFigures = std::make_unique<Figures<FigurePtr>>();
+    size_t next = state.thread_index() * 97;
+    for (auto _ : state) {
+        for (size_t i = 0; i < batchSize; ++i) {
+            std::lock_guard lock(lockedMutex);
+            lockedFigures->addFigure(pool[next++ % pool.size()]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+    if (state.thread_index() == 0)
+        lockedFigures.reset();
+}
+BENCHMARK(BM_IngestLockedFigures)->ThreadRange(1, 64)->UseRealTime();
+
+static std::unique_ptr<ConcurrentFigures<FigurePtr>> concurrentFigures;
+
+static void BM_IngestConcurrentFigures(benchmark::State &state) {
+    const auto &pool = figurePool();
+    if (state.thread_index() == 0)
+        concurrentFigures = std::make_unique<ConcurrentFigures<FigurePtr>>();
+    size_t next = state.thread_index() * 97;
+    for (auto _ : state) {
+        for (size_t i = 0; i < batchSize; ++i) {
+            concurrentFigures->addFigure(pool[next++ % pool.size()]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+    if (state.thread_index() == 0)
+        concurrentFigures.reset();
+}
+BENCHMARK(BM_IngestConcurrentFigures)->ThreadRange(1, 64)->UseRealTime();
+
+// --- Писатели и один читатель: поток 0 читает площади первых batchSize фигур
+// согласованного состояния, остальные добавляют. Работа читателя ограничена,
+// потому что все потоки делают одинаковое число итераций ---
+
+static void BM_MixedLockedFigures(benchmark::State &state) {
+    const auto &pool = figurePool();
+    if (state.thread_index() == 0)
+        lockedFigures = std::make_unique<Figures<FigurePtr>>();
+    size_t next = state.thread_index() * 97;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            std::lock_guard lock(lockedMutex);
+            double s = 0;
+            for (size_t i = 0; i < std::min(batchSize, lockedFigures->getSize()); ++i) {
+                s += (*lockedFigures)[i]->calcArea();
+            }
+            benchmark::DoNotOptimize(s);
+            continue;
+        }
+        for (size_t i = 0; i < batchSize; ++i) {
+            std::lock_guard lock(lockedMutex);
+            lockedFigures->addFigure(pool[next++ % pool.size()]);
+        }
+    }
+    if (state.thread_index() != 0)
+        state.SetItemsProcessed(state.iterations() * batchSize);
+    if (state.thread_index() == 0)
+        lockedFigures.reset();
+}
+BENCHMARK(BM_MixedLockedFigures)->ThreadRange(2, 64)->UseRealTime();
+
+static void BM_MixedConcurrentFigures(benchmark::State &state) {
+    const auto &pool = figurePool();
+    if (state.thread_index() == 0)
+        concurrentFigures = std::make_unique<ConcurrentFigures<FigurePtr>>();
+    size_t next = state.thread_index() * 97;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            auto snapshot = concurrentFigures->snapshot();
+            double s = 0;
+            snapshot->forEach(0, std::min(batchSize, snapshot->getSize()),
+                              [&](size_t, const FigurePtr &fig) { s += fig->calcArea(); });
+            benchmark::DoNotOptimize(s);
+            continue;
+        }
+        for (size_t i = 0; i < batchSize; ++i) {
+            concurrentFigures->addFigure(pool[next++ % pool.size()]);
+        }
+    }
+    if (state.thread_index() != 0)
+        state.SetItemsProcessed(state.iterations() * batchSize);
+    if (state.thread_index() == 0)
+        concurrentFigures.reset();
+}
+BENCHMARK(BM_MixedConcurrentFigures)->ThreadRange(2, 64)->UseRealTime();
+
+// Стоимость получения снимка читателем
+static void BM_Snapshot(benchmark::State &state) {
+    ConcurrentFigures<FigurePtr> figures;
+    for (const auto &fig : figurePool()) {
+        figures.addFigure(fig);
+    }
+    figures.flush();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(figures.snapshot());
+    }
+}
+BENCHMARK(BM_Snapshot);
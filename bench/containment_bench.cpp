@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "../include/containment.h"
+#include "../include/diamond.h"
+#include "../include/figures.h"
+#include "alloc_counter.h"
+
+static constexpr size_t numFigures = 1000;
+static constexpr double side = 1000;
+
+static Figures<Diamond<double>> scatteredDiamonds() {
+    Figures<Diamond<double>> figures(numFigures);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> pos(0, side), size(1.0, 20.0);
+    for (size_t i = 0; i < numFigures; ++i) {
+        double x = pos(gen), y = pos(gen), r = size(gen);
+        figures.addFigure(Diamond<double>{ { {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y} } });
+    }
+    return figures;
+}
+
+static std::vector<Point<double>> randomPoints(size_t n) {
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<double> pos(0, side);
+    std::vector<Point<double>> points;
+    points.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        points.emplace_back(pos(gen), pos(gen));
+    }
+    return points;
+}
+
+// Прежний способ: цикл по точкам и фигурам через operator[]
+static void BM_ContainmentPerPoint(benchmark::State &state) {
+    auto figures = scatteredDiamonds();
+    auto points = randomPoints(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        size_t found = 0;
+        for (const auto &p : points) {
+            for (size_t f = 0; f < figures.getSize(); ++f) {
+                auto pts = figures[f].getPoints();
+                bool inside = false;
+                for (size_t k = 0, j = pts.size() - 1; k < pts.size(); j = k++) {
+                    if ((pts[k][1] > p[1]) != (pts[j][1] > p[1]) &&
+                        p[0] < (pts[j][0] - pts[k][0]) * (p[1] - pts[k][1]) / (pts[j][1] - pts[k][1]) + pts[k][0])
+                        inside = !inside;
+                }
+                found += inside;
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ContainmentPerPoint)->RangeMultiplier(10)->Range(10'000, 100'000)->Unit(benchmark::kMillisecond);
+
+static void BM_ContainmentEngine(benchmark::State &state) {
+    auto figures = scatteredDiamonds();
+    ContainmentEngine<double> engine(figures);
+    auto points = randomPoints(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        auto result = engine.classify(points);
+        benchmark::DoNotOptimize(result.pointsInside(0).data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ContainmentEngine)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,295 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <string>
+
+#include "../include/diamond.h"
+#include "../include/figure_batch.h"
+#include "../include/figures.h"
+#include "../include/pentagon.h"
+#include "../include/trapezoid.h"
+#include "../include/versioned_figures.h"
+#include "alloc_counter.h"
+
+// Выпуклая фигура с вершинами типа Fig::value_type
+template<class Fig>
+static Fig sampleFigure(int shift = 0) {
+    using T = typename Fig::value_type;
+    T d = static_cast<T>(shift % 100);
+    if constexpr (Fig::numOfPoints == 5)
+        return Fig{ {d, 0}, {d + 4, 0}, {d + 6, 2}, {d + 3, 6}, {d - 2, 2} };
+    else if constexpr (Fig::figureKind == FigureKind::Diamond)
+        return Fig{ {d, 4}, {d + 4, 0}, {d, -4}, {d - 4, 0} };
+    else
+        return Fig{ {d, 0}, {d + 8, 0}, {d + 6, 4}, {d + 2, 4} };
+}
+
+// --- Создание и копирование фигур ---
+
+template<class Fig>
+static void BM_Construct(benchmark::State &state) {
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Fig fig = sampleFigure<Fig>();
+        benchmark::DoNotOptimize(fig);
+    }
+}
+BENCHMARK_TEMPLATE(BM_Construct, Trapezoid<double>);
+BENCHMARK_TEMPLATE(BM_Construct, Diamond<double>);
+BENCHMARK_TEMPLATE(BM_Construct, Pentagon<double>);
+
+template<class Fig>
+static void BM_Copy(benchmark::State &state) {
+    const Fig source = sampleFigure<Fig>();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Fig copy(source);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK_TEMPLATE(BM_Copy, Trapezoid<double>);
+BENCHMARK_TEMPLATE(BM_Copy, Diamond<double>);
+BENCHMARK_TEMPLATE(BM_Copy, Pentagon<double>);
+
+// --- Площадь и центр (кэш сбрасывается, чтобы мерить сам расчёт) ---
+
+template<class Fig>
+static void BM_CalcArea(benchmark::State &state) {
+    Fig fig = sampleFigure<Fig>();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        fig.invalidateCache();
+        benchmark::DoNotOptimize(fig.calcArea());
+    }
+}
+BENCHMARK_TEMPLATE(BM_CalcArea, Pentagon<int>);
+BENCHMARK_TEMPLATE(BM_CalcArea, Pentagon<float>);
+BENCHMARK_TEMPLATE(BM_CalcArea, Pentagon<double>);
+BENCHMARK_TEMPLATE(BM_CalcArea, Trapezoid<int>);
+BENCHMARK_TEMPLATE(BM_CalcArea, Trapezoid<float>);
+BENCHMARK_TEMPLATE(BM_CalcArea, Trapezoid<double>);
+
+template<class Fig>
+static void BM_CalcGeometricCenter(benchmark::State &state) {
+    Fig fig = sampleFigure<Fig>();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        fig.invalidateCache();
+        benchmark::DoNotOptimize(fig.calcGeometricCenter());
+    }
+}
+BENCHMARK_TEMPLATE(BM_CalcGeometricCenter, Pentagon<int>);
+BENCHMARK_TEMPLATE(BM_CalcGeometricCenter, Pentagon<float>);
+BENCHMARK_TEMPLATE(BM_CalcGeometricCenter, Pentagon<double>);
+BENCHMARK_TEMPLATE(BM_CalcGeometricCenter, Trapezoid<int>);
+BENCHMARK_TEMPLATE(BM_CalcGeometricCenter, Trapezoid<float>);
+BENCHMARK_TEMPLATE(BM_CalcGeometricCenter, Trapezoid<double>);
+
+// --- Figures: рост через resize, удаление, суммарная площадь ---
+
+static Figures<Diamond<double>> filledFigures(size_t n) {
+    Figures<Diamond<double>> figures(n);
+    for (size_t i = 0; i < n; ++i) {
+        figures.addFigure(sampleFigure<Diamond<double>>(static_cast<int>(i)));
+    }
+    return figures;
+}
+
+// С ёмкости 1, поэтому в замер входят все удвоения массива
+static void BM_FiguresAddFigure(benchmark::State &state) {
+    const auto fig = sampleFigure<Diamond<double>>();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Figures<Diamond<double>> figures;
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            figures.addFigure(fig);
+        }
+        benchmark::DoNotOptimize(figures.getSize());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FiguresAddFigure)->RangeMultiplier(10)->Range(1'000, 1'000'000)->Unit(benchmark::kMicrosecond);
+
+// Удаление из середины со сдвигом хвоста; фигура возвращается, чтобы размер не менялся
+static void BM_FiguresDeleteFigure(benchmark::State &state) {
+    auto figures = filledFigures(state.range(0));
+    const auto fig = sampleFigure<Diamond<double>>();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        figures.deleteFigure(static_cast<int>(figures.getSize() / 2));
+        figures.addFigure(fig);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FiguresDeleteFigure)->RangeMultiplier(10)->Range(1'000, 1'000'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_FiguresTotalArea(benchmark::State &state) {
+    auto figures = filledFigures(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(figures.calcTotalArea());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FiguresTotalArea)->RangeMultiplier(10)->Range(1'000, 1'000'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_FiguresTotalAreaParallel(benchmark::State &state) {
+    auto figures = filledFigures(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(figures.calcTotalArea(ReduceOptions{}));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FiguresTotalAreaParallel)->RangeMultiplier(10)->Range(1'000, 1'000'000)->Unit(benchmark::kMicrosecond);
+
+// Опрос сводки, когда между опросами коллекция меняется на одну фигуру
+static void BM_FiguresEditAndPollAggregates(benchmark::State &state) {
+    auto figures = filledFigures(state.range(0));
+    const auto fig = sampleFigure<Diamond<double>>();
+    size_t next = 0;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        figures.modifyFigure(next++ % figures.getSize(), [&](auto &item) { item = fig; });
+        benchmark::DoNotOptimize(figures.getAggregates());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FiguresEditAndPollAggregates)->RangeMultiplier(10)->Range(1'000, 1'000'000)->Unit(benchmark::kMicrosecond);
+
+// --- Потоковый ввод-вывод одной фигуры ---
+
+template<class Fig>
+static void BM_StreamWrite(benchmark::State &state) {
+    const Fig fig = sampleFigure<Fig>();
+    std::ostringstream os;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        os.str(std::string());
+        os << fig;
+        benchmark::DoNotOptimize(os.tellp());
+    }
+}
+BENCHMARK_TEMPLATE(BM_StreamWrite, Trapezoid<double>);
+BENCHMARK_TEMPLATE(BM_StreamWrite, Pentagon<double>);
+BENCHMARK_TEMPLATE(BM_StreamWrite, Pentagon<int>);
+
+template<class Fig>
+static void BM_StreamRead(benchmark::State &state) {
+    std::ostringstream text;
+    for (const auto &p : sampleFigure<Fig>().getPoints()) {
+        text << p[0] << ' ' << p[1] << ' ';
+    }
+    const std::string input = text.str();
+    std::istringstream is;
+    Fig fig;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        is.clear();
+        is.str(input);
+        is >> fig;
+        benchmark::DoNotOptimize(fig);
+    }
+}
+BENCHMARK_TEMPLATE(BM_StreamRead, Trapezoid<double>);
+BENCHMARK_TEMPLATE(BM_StreamRead, Pentagon<double>);
+BENCHMARK_TEMPLATE(BM_StreamRead, Pentagon<int>);
+
+// --- Пакетные площади целочисленных фигур: через double и точно в int64 ---
+
+static FigureBatch<int> intBatch(size_t n) {
+    FigureBatch<int> batch;
+    for (size_t i = 0; i < n; ++i) {
+        batch.addFigure(sampleFigure<Trapezoid<int>>(static_cast<int>(i)));
+    }
+    return batch;
+}
+
+static void BM_BatchAreasIntViaDouble(benchmark::State &state) {
+    auto batch = intBatch(state.range(0));
+    std::vector<double> out(batch.getSize());
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        batch.getQuads().calcDoubleAreasSigned(out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BatchAreasIntViaDouble)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_BatchAreasIntExact(benchmark::State &state) {
+    auto batch = intBatch(state.range(0));
+    std::vector<int64_t> out(batch.getSize());
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        batch.getQuads().view().calcDoubleAreasExact(out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BatchAreasIntExact)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+
+// --- Пакетные центры пятиугольников: double и float ---
+
+template<Scalar T>
+static FigureBatch<T> pentagonBatch(size_t n) {
+    FigureBatch<T> batch;
+    for (size_t i = 0; i < n; ++i) {
+        batch.addFigure(sampleFigure<Pentagon<T>>(static_cast<int>(i)));
+    }
+    return batch;
+}
+
+static void BM_BatchCentroidsDouble(benchmark::State &state) {
+    auto batch = pentagonBatch<double>(state.range(0));
+    std::vector<double> s(batch.getSize()), cx(batch.getSize()), cy(batch.getSize());
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        batch.getPentagons().view().calcCentroidSums(s.data(), cx.data(), cy.data());
+        benchmark::DoNotOptimize(cx.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BatchCentroidsDouble)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_BatchCentroidsFloat(benchmark::State &state) {
+    auto batch = pentagonBatch<float>(state.range(0));
+    std::vector<float> s(batch.getSize()), cx(batch.getSize()), cy(batch.getSize());
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        batch.getPentagons().view().calcCentroidsFloat(s.data(), cx.data(), cy.data());
+        benchmark::DoNotOptimize(cx.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BatchCentroidsFloat)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+
+// --- Версия массива перед правкой: полная копия Figures и снимок VersionedFigures ---
+
+static void BM_CopyAndEditFigures(benchmark::State &state) {
+    Figures<Trapezoid<double>> figures;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        figures.addFigure(sampleFigure<Trapezoid<double>>(static_cast<int>(i)));
+    }
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Figures<Trapezoid<double>> version(figures);
+        version[version.getSize() / 2] = sampleFigure<Trapezoid<double>>(1);
+        benchmark::DoNotOptimize(version.begin());
+    }
+}
+BENCHMARK(BM_CopyAndEditFigures)->Arg(1'000'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_SnapshotAndEditVersioned(benchmark::State &state) {
+    VersionedFigures<Trapezoid<double>> figures;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        figures.addFigure(sampleFigure<Trapezoid<double>>(static_cast<int>(i)));
+    }
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        auto version = figures.snapshot();
+        version.setFigure(version.getSize() / 2, sampleFigure<Trapezoid<double>>(1));
+        benchmark::DoNotOptimize(version);
+    }
+}
+BENCHMARK(BM_SnapshotAndEditVersioned)->Arg(1'000'000)->Unit(benchmark::kMicrosecond);
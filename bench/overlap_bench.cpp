@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "../include/diamond.h"
+#include "../include/figures.h"
+#include "../include/overlap.h"
+#include "alloc_counter.h"
+
+// n ромбов с постоянной плотностью: у каждого в среднем несколько соседей
+static Figures<Diamond<double>> scatteredDiamonds(size_t n) {
+    Figures<Diamond<double>> figures(n);
+    std::mt19937 gen(1);
+    const double side = std::sqrt(static_cast<double>(n)) * 4;
+    std::uniform_real_distribution<double> pos(0, side), size(0.5, 3.0);
+    for (size_t i = 0; i < n; ++i) {
+        double x = pos(gen), y = pos(gen), r = size(gen);
+        figures.addFigure(Diamond<double>{ { {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y} } });
+    }
+    return figures;
+}
+
+static void BM_OverlapsAllPairs(benchmark::State &state) {
+    auto figures = scatteredDiamonds(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        size_t found = 0;
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            for (size_t j = i + 1; j < figures.getSize(); ++j) {
+                found += intersectionArea(figures[i], figures[j]) > 0;
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OverlapsAllPairs)->RangeMultiplier(10)->Range(1'000, 10'000)->Unit(benchmark::kMillisecond);
+
+static void BM_OverlapsSweep(benchmark::State &state) {
+    auto figures = scatteredDiamonds(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        auto overlaps = findOverlaps(figures);
+        benchmark::DoNotOptimize(overlaps.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OverlapsSweep)->RangeMultiplier(10)->Range(1'000, 100'000)->Unit(benchmark::kMillisecond);
+
+static void BM_UnionArea(benchmark::State &state) {
+    auto figures = scatteredDiamonds(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(figures.calcUnionArea());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UnionArea)->RangeMultiplier(10)->Range(1'000, 100'000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+
+#include "../include/diamond.h"
+#include "../include/figures.h"
+#include "../include/pentagon.h"
+#include "../include/shape_validation.h"
+#include "../include/trapezoid.h"
+#include "alloc_counter.h"
+
+// Смесь всех трёх видов со случайным сдвигом; часть ромбов испорчена
+static Figures<std::shared_ptr<Figure<double>>> randomShapes(size_t n) {
+    Figures<std::shared_ptr<Figure<double>>> figures(n);
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> pos(-1000, 1000);
+    for (size_t i = 0; i < n; ++i) {
+        double x = pos(gen), y = pos(gen);
+        if (i % 3 == 0)
+            figures.addFigure(std::make_shared<Trapezoid<double>>(
+                Trapezoid<double>{ {x, y}, {x + 8, y}, {x + 6, y + 4}, {x + 2, y + 4} }));
+        else if (i % 3 == 1)
+            figures.addFigure(std::make_shared<Diamond<double>>(
+                Diamond<double>{ {x, y + 3}, {x + 4, y}, {x, y - 3}, {x - 4 + (i % 10 == 1), y} }));
+        else
+            figures.addFigure(std::make_shared<Pentagon<double>>(
+                Pentagon<double>{ {x, y}, {x + 4, y}, {x + 6, y + 2}, {x + 3, y + 6}, {x - 2, y + 2} }));
+    }
+    return figures;
+}
+
+// Аргументы: число фигур, число потоков (0 - все ядра)
+static void BM_ValidateShapes(benchmark::State &state) {
+    auto figures = randomShapes(state.range(0));
+    const ReduceOptions options{static_cast<size_t>(state.range(1)), 1024};
+    AllocCounter allocs(state);
+    ShapeValidationStats stats;
+    for (auto _ : state) {
+        auto result = validateShapes(figures, options);
+        stats = result.getStats();
+        benchmark::DoNotOptimize(result.getValidBits().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["exact_share"] =
+        static_cast<double>(stats.exactPredicates) / (stats.exactPredicates + stats.filteredPredicates);
+}
+BENCHMARK(BM_ValidateShapes)->Args({100'000, 1})->Args({100'000, 0})->Unit(benchmark::kMillisecond);
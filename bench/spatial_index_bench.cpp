@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../include/diamond.h"
+#include "../include/figures.h"
+#include "../include/spatial_index.h"
+#include "alloc_counter.h"
+
+// n небольших ромбов, равномерно разбросанных так, что плотность не зависит от n
+static const Figures<Diamond<double>> &scatteredDiamonds(size_t n) {
+    static std::map<size_t, std::unique_ptr<Figures<Diamond<double>>>> cache;
+    auto &figures = cache[n];
+    if (!figures) {
+        figures = std::make_unique<Figures<Diamond<double>>>(n);
+        std::mt19937 gen(1);
+        const double side = std::sqrt(static_cast<double>(n)) * 4;
+        std::uniform_real_distribution<double> pos(0, side), size(0.2, 2.0);
+        for (size_t i = 0; i < n; ++i) {
+            double x = pos(gen), y = pos(gen), r = size(gen);
+            figures->addFigure(Diamond<double>{ { {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y} } });
+            std::as_const(*figures)[i].calcBoundingBox();
+        }
+    }
+    return *figures;
+}
+
+static std::vector<BoundingBox<double>> queryWindows(size_t n, size_t count) {
+    std::mt19937 gen(2);
+    const double side = std::sqrt(static_cast<double>(n)) * 4;
+    std::uniform_real_distribution<double> pos(0, side);
+    std::vector<BoundingBox<double>> windows;
+    for (size_t i = 0; i < count; ++i) {
+        double x = pos(gen), y = pos(gen);
+        windows.push_back({x, y, x + 10, y + 10});
+    }
+    return windows;
+}
+
+static void BM_WindowQueryBruteForce(benchmark::State &state) {
+    const auto &figures = scatteredDiamonds(state.range(0));
+    auto windows = queryWindows(state.range(0), 64);
+    size_t q = 0, found = 0;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        const auto &window = windows[q++ % windows.size()];
+        for (const auto &fig : figures) {
+            found += fig.calcBoundingBox().intersects(window);
+        }
+    }
+    benchmark::DoNotOptimize(found);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WindowQueryBruteForce)->RangeMultiplier(10)->Range(10'000, 10'000'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_WindowQueryGrid(benchmark::State &state) {
+    const auto &figures = scatteredDiamonds(state.range(0));
+    SpatialGrid<double> grid(SpatialGrid<double>::suggestCellSize(figures));
+    grid.build(figures);
+    auto windows = queryWindows(state.range(0), 64);
+    std::vector<FigureHandle> out;
+    size_t q = 0;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        out.clear();
+        grid.queryWindow(windows[q++ % windows.size()], out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WindowQueryGrid)->RangeMultiplier(10)->Range(10'000, 10'000'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_PointQueryGrid(benchmark::State &state) {
+    const auto &figures = scatteredDiamonds(state.range(0));
+    SpatialGrid<double> grid(SpatialGrid<double>::suggestCellSize(figures));
+    grid.build(figures);
+    auto windows = queryWindows(state.range(0), 64);
+    std::vector<FigureHandle> out;
+    size_t q = 0;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        const auto &w = windows[q++ % windows.size()];
+        out.clear();
+        grid.queryPoint(Point<double>(w.minX, w.minY), out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PointQueryGrid)->RangeMultiplier(10)->Range(10'000, 10'000'000)->Unit(benchmark::kMicrosecond);
+
+static void BM_GridBuild(benchmark::State &state) {
+    const auto &figures = scatteredDiamonds(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        SpatialGrid<double> grid(SpatialGrid<double>::suggestCellSize(figures));
+        grid.build(figures);
+        benchmark::DoNotOptimize(grid.getSize());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GridBuild)->RangeMultiplier(10)->Range(10'000, 10'000'000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "../include/figure_text.h"
+#include "../include/figures.h"
+#include "../include/pentagon.h"
+#include "alloc_counter.h"
+
+// Текст из n пятиугольников в формате operator>>, строится один раз на размер
+static const std::string &pentagonText(size_t n) {
+    static std::map<size_t, std::string> cache;
+    auto &text = cache[n];
+    if (text.empty()) {
+        std::ostringstream os;
+        for (size_t i = 0; i < n; ++i) {
+            double d = static_cast<double>(i % 1000) / 8;
+            os << d << ' ' << 0 << "  " << d + 2 << ' ' << 0 << "  " << d + 3 << ' ' << 1 << "  "
+               << d + 1.5 << ' ' << 3 << "  " << d - 0.5 << ' ' << 1 << '\n';
+        }
+        text = os.str();
+    }
+    return text;
+}
+
+static void BM_ParseIostream(benchmark::State &state) {
+    const std::string &text = pentagonText(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        std::istringstream is(text);
+        Figures<Pentagon<double>> figures;
+        Pentagon<double> p;
+        while (is >> p) {
+            figures.addFigure(p);
+        }
+        benchmark::DoNotOptimize(figures.getSize());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParseIostream)->Arg(1'000'000)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+
+static void BM_ParseFromChars(benchmark::State &state) {
+    const std::string &text = pentagonText(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Figures<Pentagon<double>> figures;
+        parseFigures<Pentagon<double>>(text, figures);
+        benchmark::DoNotOptimize(figures.getSize());
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParseFromChars)->Arg(1'000'000)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
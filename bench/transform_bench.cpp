@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "../include/affine.h"
+#include "../include/diamond.h"
+#include "../include/figure_batch.h"
+#include "../include/figures.h"
+#include "alloc_counter.h"
+
+static Figures<Diamond<double>> randomDiamonds(size_t n) {
+    Figures<Diamond<double>> figures(n);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> pos(-1000, 1000), size(0.5, 3.0);
+    for (size_t i = 0; i < n; ++i) {
+        double x = pos(gen), y = pos(gen), r = size(gen);
+        figures.addFigure(Diamond<double>{ { {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y} } });
+    }
+    return figures;
+}
+
+static const Affine2 frameStep = Affine2::rotation(1e-3) * Affine2::translation(0.5, -0.25);
+
+// Прежний способ: пересобрать каждую фигуру через initializer_list
+static void BM_TransformRebuild(benchmark::State &state) {
+    auto figures = randomDiamonds(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            auto pts = figures[i].getPoints();
+            figures[i] = Diamond<double>{ { frameStep.apply(pts[0]), frameStep.apply(pts[1]),
+                                            frameStep.apply(pts[2]), frameStep.apply(pts[3]) } };
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformRebuild)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
+
+static void BM_TransformFigures(benchmark::State &state) {
+    auto figures = randomDiamonds(state.range(0));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        figures.transform(frameStep);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformFigures)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
+
+static void BM_TransformBatch(benchmark::State &state) {
+    FigureBatch<double> batch(randomDiamonds(state.range(0)));
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        batch.transform(frameStep);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformBatch)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,54 @@
+#include "alloc_hooks.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<size_t> allocations{0};
+thread_local AllocationHook threadHook = nullptr;
+
+void record(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (threadHook != nullptr)
+        threadHook(size);
+}
+
+void *allocate(size_t size) {
+    record(size);
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *allocateAligned(size_t size, std::align_val_t align) {
+    record(size);
+    const size_t alignment = static_cast<size_t>(align);
+    const size_t rounded = (size + alignment - 1) / alignment * alignment;
+    if (void *p = std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded))
+        return p;
+    throw std::bad_alloc();
+}
+} // namespace
+
+size_t allocationCount() { return allocations.load(std::memory_order_relaxed); }
+
+AllocationHook setThreadAllocationHook(AllocationHook hook) {
+    AllocationHook previous = threadHook;
+    threadHook = hook;
+    return previous;
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void *operator new(size_t size, std::align_val_t align) { return allocateAligned(size, align); }
+void *operator new[](size_t size, std::align_val_t align) { return allocateAligned(size, align); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { std::free(p); }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+// Подмена глобальных operator new/delete (alloc_hooks.cpp), общая для тестов и
+// бенчмарков. Сама она только считает выделения; подсчёт по областям строится
+// поверх неё через обработчик потока (см. test/alloc_tracker.h).
+
+// Число вызовов глобального operator new с начала программы (все потоки)
+size_t allocationCount();
+
+// Вызывается из operator new с размером выделения в потоке, где установлен
+using AllocationHook = void (*)(size_t size);
+
+// Устанавливает обработчик для текущего потока (nullptr - снять), возвращает прежний
+AllocationHook setThreadAllocationHook(AllocationHook hook);
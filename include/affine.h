@@ -0,0 +1,58 @@
+#pragma once
+
+#include "point.h"
+#include <cmath>
+#include <type_traits>
+
+// Аффинное преобразование плоскости, матрица 2x3:
+//   x' = a * x + b * y + tx
+//   y' = c * x + d * y + ty
+// Как и ядра из simd_kernels.h, считается без FMA, поэтому Figure::transform и
+// FigureColumns::transform дают одинаковые координаты.
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+struct Affine2 {
+    double a = 1, b = 0, tx = 0;
+    double c = 0, d = 1, ty = 0;
+
+    static Affine2 identity() { return {}; }
+
+    static Affine2 translation(double dx, double dy) { return {1, 0, dx, 0, 1, dy}; }
+
+    static Affine2 scaling(double sx, double sy) { return {sx, 0, 0, 0, sy, 0}; }
+
+    // Поворот на angle радиан против часовой стрелки вокруг начала координат
+    static Affine2 rotation(double angle) {
+        const double cs = std::cos(angle), sn = std::sin(angle);
+        return {cs, -sn, 0, sn, cs, 0};
+    }
+
+    // Композиция: сначала other, затем *this
+    Affine2 operator*(const Affine2 &other) const {
+        return {a * other.a + b * other.c, a * other.b + b * other.d, a * other.tx + b * other.ty + tx,
+                c * other.a + d * other.c, c * other.b + d * other.d, c * other.tx + d * other.ty + ty};
+    }
+
+    // Во сколько раз меняется ориентированная площадь
+    double determinant() const { return a * d - b * c; }
+
+    // Целые координаты округляются до ближайшего
+    template<Scalar T>
+    Point<T> apply(const Point<T> &p) const {
+        const double x = p[0], y = p[1];
+        return Point<T>(toScalar<T>(a * x + b * y + tx), toScalar<T>(c * x + d * y + ty));
+    }
+
+    template<Scalar T>
+    static T toScalar(double value) {
+        if constexpr (std::is_integral_v<T>)
+            return static_cast<T>(std::llround(value));
+        else
+            return static_cast<T>(value);
+    }
+
+    bool operator==(const Affine2 &other) const = default;
+};
+
+#pragma GCC pop_options
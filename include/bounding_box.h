@@ -0,0 +1,27 @@
+#pragma once
+
+#include "point.h"
+#include <algorithm>
+
+// Ограничивающий прямоугольник со сторонами, параллельными осям (границы включаются)
+template<Scalar T>
+struct BoundingBox {
+    T minX = 0, minY = 0, maxX = 0, maxY = 0;
+
+    constexpr bool contains(const Point<T> &p) const {
+        return p[0] >= minX && p[0] <= maxX && p[1] >= minY && p[1] <= maxY;
+    }
+
+    constexpr bool intersects(const BoundingBox &other) const {
+        return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+    }
+
+    constexpr void expand(const Point<T> &p) {
+        minX = std::min(minX, p[0]);
+        minY = std::min(minY, p[1]);
+        maxX = std::max(maxX, p[0]);
+        maxY = std::max(maxY, p[1]);
+    }
+
+    constexpr bool operator==(const BoundingBox &other) const = default;
+};
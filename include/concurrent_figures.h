@@ -0,0 +1,243 @@
+#pragma once
+
+#include "figure_report.h"
+#include "figures.h"
+#include "parallel_reduce.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ячейка с shared_ptr в духе RCU: читатели не берут блокировок, запись
+// (только одним писателем за раз) ждёт, пока выйдут читатели старого значения,
+// и только потом освобождает его. Используются два счётчика читателей по
+// чётности эпохи. Вместо atomic<shared_ptr> - его реализация в libstdc++
+// синхронизируется битом в указателе, который не видит ThreadSanitizer.
+template<class V>
+class RcuCell {
+  public:
+    explicit RcuCell(std::shared_ptr<const V> value) : current(new Node{std::move(value)}) {}
+    RcuCell(const RcuCell &) = delete;
+    RcuCell &operator=(const RcuCell &) = delete;
+    ~RcuCell() { delete current.load(); }
+
+    std::shared_ptr<const V> load() const {
+        for (;;) {
+            const size_t e = epoch.load();
+            readers[e & 1].fetch_add(1);
+            if (epoch.load() == e) {
+                std::shared_ptr<const V> value = current.load()->value;
+                readers[e & 1].fetch_sub(1);
+                return value;
+            }
+            readers[e & 1].fetch_sub(1);    // писатель сменил эпоху, пробуем снова
+        }
+    }
+
+    // Вызовы store не должны пересекаться между собой
+    void store(std::shared_ptr<const V> value) {
+        Node *old = current.exchange(new Node{std::move(value)});
+        const size_t e = epoch.fetch_add(1);
+        while (readers[e & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+        delete old;
+    }
+
+  private:
+    struct Node {
+        std::shared_ptr<const V> value;
+    };
+
+    std::atomic<Node *> current;
+    std::atomic<size_t> epoch{0};
+    mutable std::atomic<size_t> readers[2]{};
+};
+
+// Неизменяемый снимок ConcurrentFigures: набор запечатанных кусков, которые
+// больше никто не меняет. Снимок держит куски через shared_ptr, поэтому остаётся
+// действительным, пока жив, сколько бы фигур ни добавили после него.
+template<class T>
+class FigureSnapshot {
+  public:
+    using Chunk = std::vector<T>;
+
+    FigureSnapshot() = default;
+
+    size_t getSize() const { return size; }
+
+    // Поиск куска по позиции - O(log числа кусков)
+    const T &operator[](size_t index) const {
+        size_t chunk = std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin() - 1;
+        return (*chunks[chunk])[index - offsets[chunk]];
+    }
+
+    // Вызывает f(index, элемент) для позиций [begin, end) подряд
+    template<class F>
+    void forEach(size_t begin, size_t end, F &&f) const {
+        if (begin >= end)
+            return;
+        size_t chunk = std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1;
+        size_t i = begin - offsets[chunk];
+        for (size_t index = begin; index < end; ++index, ++i) {
+            if (i == chunks[chunk]->size()) {
+                ++chunk;
+                i = 0;
+            }
+            f(index, (*chunks[chunk])[i]);
+        }
+    }
+
+    // Результат не зависит от options.threads (см. Figures::calcTotalArea)
+    double calcTotalArea(const ReduceOptions &options = {}) const {
+        CompensatedSum total = parallelReduce(size, options, CompensatedSum{},
+            [this](size_t begin, size_t end) {
+                CompensatedSum s;
+                forEach(begin, end, [&](size_t, const T &fig) { s.add(Figures<T>::deref(fig).calcArea()); });
+                return s;
+            },
+            [](CompensatedSum a, const CompensatedSum &b) {
+                a.add(b);
+                return a;
+            });
+        return total.result();
+    }
+
+    void writeReport(ReportWriter &writer) const {
+        forEach(0, size, [&](size_t index, const T &fig) { writer.writeFigure(index, Figures<T>::deref(fig)); });
+    }
+
+    void printCenterForEachFigure() const { printReport(ReportCenter); }
+    void printAreaForEachFigure() const { printReport(ReportArea); }
+    void printCenterAndAreaForEachFigure() const { printReport(ReportCenterAndArea); }
+
+  private:
+    template<class>
+    friend class ConcurrentFigures;
+
+    void append(std::shared_ptr<const Chunk> chunk) {
+        offsets.push_back(size);
+        size += chunk->size();
+        chunks.push_back(std::move(chunk));
+    }
+
+    void printReport(unsigned fields) const {
+        std::string buffer;
+        ReportWriter writer(std::cout, ReportFormat::Text, buffer, fields);
+        writeReport(writer);
+    }
+
+    std::vector<std::shared_ptr<const Chunk>> chunks;
+    std::vector<size_t> offsets;    // offsets[k] - позиция первого элемента chunks[k]
+    size_t size = 0;
+};
+
+struct ConcurrentFiguresOptions {
+    size_t shards = 16;
+    // Шард публикует накопленное, когда в нём не меньше
+    // clamp(размер снимка / 16, minChunkSize, maxChunkSize) фигур: пока снимок
+    // меньше 16 * maxChunkSize, кусков O(log n), дальше - n / maxChunkSize
+    size_t minChunkSize = 256;
+    // Граница отставания: в шарде никогда не ждёт больше maxChunkSize - 1 фигур
+    size_t maxChunkSize = 1 << 16;
+};
+
+// Контейнер для одновременного добавления фигур из многих потоков и чтения без
+// блокировок. Производители пишут в свой шард (мьютекс на шард, потоки
+// распределены по шардам по кругу), заполненный шард запечатывается в кусок и
+// публикуется новым снимком через RcuCell - читатели получают его
+// через snapshot() и не ждут писателей, старые куски освобождаются вместе с
+// последним снимком, который на них ссылается.
+// Перед вставкой у фигуры прогревается кэш (Figure::warmCache), поэтому снимок
+// можно читать из любого числа потоков. Порядок сохраняется внутри потока,
+// между потоками не определён. Только что добавленная фигура видна в snapshot()
+// после публикации её шарда или после flush(). В худшем случае снимок отстаёт
+// на shards * (maxChunkSize - 1) фигур: фигура становится видна не позже, чем
+// в её шард добавят ещё maxChunkSize - 1 фигур. Если поток больше ничего не
+// добавляет, его шард публикует только flush().
+template<class T>
+class ConcurrentFigures {
+  public:
+    using Snapshot = FigureSnapshot<T>;
+
+    explicit ConcurrentFigures(const ConcurrentFiguresOptions &options = {})
+        : options(options), shards(std::max<size_t>(1, options.shards)),
+          published(std::make_shared<const Snapshot>()) {}
+
+    ConcurrentFigures(const ConcurrentFigures &) = delete;
+    ConcurrentFigures &operator=(const ConcurrentFigures &) = delete;
+
+    void addFigure(T fig) {
+        Figures<T>::deref(fig).warmCache();
+        Shard &shard = shards[shardIndex()];
+        std::lock_guard lock(shard.mutex);
+        shard.pending.push_back(std::move(fig));
+        // Публикация под мьютексом шарда: иначе кусок, запечатанный позже,
+        // мог бы обогнать более ранний и нарушить порядок внутри потока
+        if (shard.pending.size() >= sealThreshold.load(std::memory_order_relaxed))
+            publish({std::make_shared<const Chunk>(std::exchange(shard.pending, {}))});
+    }
+
+    // Публикует всё, что добавлено до вызова
+    void flush() {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        std::vector<std::shared_ptr<const Chunk>> sealed;
+        for (Shard &shard : shards) {
+            locks.emplace_back(shard.mutex);
+            if (!shard.pending.empty())
+                sealed.push_back(std::make_shared<const Chunk>(std::exchange(shard.pending, {})));
+        }
+        if (!sealed.empty())
+            publish(std::move(sealed));
+    }
+
+    // Последний опубликованный снимок
+    std::shared_ptr<const Snapshot> snapshot() const {
+        return published.load();
+    }
+
+    size_t getPublishedSize() const { return snapshot()->getSize(); }
+
+  private:
+    using Chunk = typename Snapshot::Chunk;
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        Chunk pending;
+    };
+
+    size_t sealThresholdFor(size_t publishedSize) const {
+        const size_t maxChunk = std::max<size_t>(1, options.maxChunkSize);
+        return std::clamp(publishedSize / 16, std::min(options.minChunkSize, maxChunk), maxChunk);
+    }
+
+    size_t shardIndex() const {
+        static std::atomic<size_t> nextThread{0};
+        thread_local const size_t thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+        return thread % shards.size();
+    }
+
+    // Новый снимок = старый + sealed. Публикации идут по одной, чтения не ждут.
+    // Мьютексы шардов берутся раньше publishMutex
+    void publish(std::vector<std::shared_ptr<const Chunk>> sealed) {
+        std::lock_guard lock(publishMutex);
+        auto next = std::make_shared<Snapshot>(*published.load());
+        for (auto &chunk : sealed) {
+            next->append(std::move(chunk));
+        }
+        sealThreshold.store(sealThresholdFor(next->getSize()), std::memory_order_relaxed);
+        published.store(std::move(next));
+    }
+
+    ConcurrentFiguresOptions options;
+    std::vector<Shard> shards;
+    std::atomic<size_t> sealThreshold{sealThresholdFor(0)};
+    std::mutex publishMutex;
+    RcuCell<Snapshot> published;
+};
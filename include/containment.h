@@ -0,0 +1,177 @@
+#pragma once
+
+#include "bounding_box.h"
+#include "figures.h"
+#include "parallel_reduce.h"
+#include "point.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+// Результат пакетной проверки: для каждой фигуры возрастающий список номеров
+// точек внутри неё. Списки лежат подряд в одном массиве, поэтому память
+// пропорциональна числу попаданий, а не произведению числа фигур и точек
+class ContainmentResult {
+  public:
+    ContainmentResult() = default;
+    // offsets[f] - начало списка фигуры f в indices, offsets.back() == indices.size()
+    ContainmentResult(std::vector<size_t> offsets, std::vector<uint32_t> indices, size_t numPoints)
+        : numPoints(numPoints), offsets(std::move(offsets)), indices(std::move(indices)) {}
+
+    bool contains(size_t figure, size_t point) const {
+        auto inside = pointsInside(figure);
+        return std::binary_search(inside.begin(), inside.end(), static_cast<uint32_t>(point));
+    }
+
+    // Номера точек внутри фигуры по возрастанию
+    std::span<const uint32_t> pointsInside(size_t figure) const {
+        return {indices.data() + offsets[figure], offsets[figure + 1] - offsets[figure]};
+    }
+
+    size_t countInside(size_t figure) const { return offsets[figure + 1] - offsets[figure]; }
+
+    size_t getNumFigures() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t getNumPoints() const { return numPoints; }
+
+  private:
+    size_t numPoints = 0;
+    std::vector<size_t> offsets;
+    std::vector<uint32_t> indices;
+};
+
+// Пакетная проверка принадлежности точек фигурам (правило чётности пересечений).
+// Уравнения рёбер каждой фигуры считаются один раз при построении. Точки
+// сортируются по x, поэтому для фигуры проверяется только сплошной диапазон точек
+// в пределах её прямоугольника, а внутренний цикл по точкам векторизуется.
+// Точки ровно на границе могут оказаться как внутри, так и снаружи.
+template<Scalar T>
+class ContainmentEngine {
+  public:
+    static constexpr size_t maxEdges = 5;
+
+    template<class U>
+    explicit ContainmentEngine(const Figures<U> &figures) {
+        polygons.reserve(figures.getSize());
+        for (const auto &item : figures) {
+            addFigure(Figures<U>::deref(item));
+        }
+    }
+
+    void addFigure(const Figure<T> &fig) {
+        auto points = fig.getPoints();
+        assert(points.size() <= maxEdges);
+        Polygon poly;
+        poly.box = fig.calcBoundingBox();
+        poly.numEdges = points.size();
+        for (size_t k = 0; k < points.size(); ++k) {
+            const auto &a = points[k];
+            const auto &b = points[(k + 1 == points.size()) ? 0 : k + 1];
+            poly.x0[k] = a[0];
+            poly.y0[k] = a[1];
+            poly.y1[k] = b[1];
+            // Горизонтальные рёбра никогда не пересекаются лучом, наклон для них не важен
+            poly.invSlope[k] = (b[1] != a[1]) ? (static_cast<double>(b[0]) - a[0]) / (static_cast<double>(b[1]) - a[1]) : 0;
+        }
+        polygons.push_back(poly);
+    }
+
+    // options.chunkSize здесь - число фигур в куске
+    ContainmentResult classify(std::span<const Point<T>> points, const ReduceOptions &options = {0, 64}) const {
+        std::vector<double> xs(points.size()), ys(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            xs[i] = points[i][0];
+            ys[i] = points[i][1];
+        }
+        return classify(xs, ys, options);
+    }
+
+    // Точки в виде столбцов x и y одинаковой длины
+    ContainmentResult classify(std::span<const double> xs, std::span<const double> ys,
+                               const ReduceOptions &options = {0, 64}) const {
+        assert(xs.size() == ys.size());
+        const size_t n = xs.size();
+        std::vector<uint32_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return xs[a] < xs[b]; });
+        std::vector<double> sx(n), sy(n);
+        for (size_t i = 0; i < n; ++i) {
+            sx[i] = xs[order[i]];
+            sy[i] = ys[order[i]];
+        }
+
+        // Каждый кусок фигур собирает свои списки, затем они склеиваются по порядку
+        struct ChunkHits {
+            std::vector<size_t> counts;
+            std::vector<uint32_t> indices;
+        };
+        const size_t chunkSize = std::max<size_t>(1, options.chunkSize);
+        std::vector<ChunkHits> chunks((polygons.size() + chunkSize - 1) / chunkSize);
+        parallelForChunks(polygons.size(), options, [&](size_t begin, size_t end, size_t chunk) {
+            std::array<uint8_t, blockSize> inside;
+            ChunkHits &hits = chunks[chunk];
+            hits.counts.resize(end - begin);
+            for (size_t f = begin; f < end; ++f) {
+                const Polygon &poly = polygons[f];
+                auto lo = std::lower_bound(sx.begin(), sx.end(), static_cast<double>(poly.box.minX)) - sx.begin();
+                auto hi = std::upper_bound(sx.begin(), sx.end(), static_cast<double>(poly.box.maxX)) - sx.begin();
+                const size_t first = hits.indices.size();
+                for (size_t blockStart = lo; blockStart < static_cast<size_t>(hi); blockStart += blockSize) {
+                    size_t count = std::min<size_t>(blockSize, hi - blockStart);
+                    testBlock(poly, sx.data() + blockStart, sy.data() + blockStart, count, inside.data());
+                    for (size_t i = 0; i < count; ++i) {
+                        if (inside[i])
+                            hits.indices.push_back(order[blockStart + i]);
+                    }
+                }
+                // Точки шли в порядке x, список - по номерам
+                std::sort(hits.indices.begin() + first, hits.indices.end());
+                hits.counts[f - begin] = hits.indices.size() - first;
+            }
+        });
+
+        std::vector<size_t> offsets(1, 0);
+        offsets.reserve(polygons.size() + 1);
+        for (const auto &hits : chunks) {
+            for (size_t count : hits.counts) {
+                offsets.push_back(offsets.back() + count);
+            }
+        }
+        std::vector<uint32_t> indices;
+        indices.reserve(offsets.back());
+        for (auto &hits : chunks) {
+            indices.insert(indices.end(), hits.indices.begin(), hits.indices.end());
+            hits.indices = {};
+        }
+        return ContainmentResult(std::move(offsets), std::move(indices), n);
+    }
+
+    size_t getSize() const { return polygons.size(); }
+
+  private:
+    static constexpr size_t blockSize = 256;
+
+    struct Polygon {
+        BoundingBox<T> box;
+        size_t numEdges = 0;
+        std::array<double, maxEdges> x0{}, y0{}, y1{}, invSlope{};
+    };
+
+    // Без ветвлений по точкам: на каждое ребро один проход по блоку
+    static void testBlock(const Polygon &poly, const double *px, const double *py, size_t count, uint8_t *inside) {
+        std::fill_n(inside, count, 0);
+        for (size_t e = 0; e < poly.numEdges; ++e) {
+            const double x0 = poly.x0[e], y0 = poly.y0[e], y1 = poly.y1[e], k = poly.invSlope[e];
+            for (size_t i = 0; i < count; ++i) {
+                const bool straddles = (y0 > py[i]) != (y1 > py[i]);
+                const bool left = px[i] < x0 + (py[i] - y0) * k;
+                inside[i] ^= static_cast<uint8_t>(straddles & left);
+            }
+        }
+    }
+
+    std::vector<Polygon> polygons;
+};
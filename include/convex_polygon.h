@@ -0,0 +1,519 @@
+#pragma once
+
+#include "bounding_box.h"
+#include "exact_predicates.h"
+#include "figure.h"
+#include "parallel_reduce.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Выпуклый многоугольник в координатах double. Пересечение двух выпуклых фигур
+// имеет не больше n + m вершин, поэтому хватает массива на стеке.
+struct ConvexPolygon {
+    static constexpr size_t maxVertices = 16;
+
+    std::array<double, maxVertices> x{}, y{};
+    size_t size = 0;
+
+    template<Scalar T>
+    static ConvexPolygon from(const Figure<T> &fig) {
+        ConvexPolygon poly;
+        for (const auto &p : fig.getPoints()) {
+            poly.push(p[0], p[1]);
+        }
+        return poly;
+    }
+
+    void push(double px, double py) {
+        x[size] = px;
+        y[size] = py;
+        size++;
+    }
+
+    double areaSigned() const {
+        double sum = 0;
+        for (size_t i = 0; i < size; ++i) {
+            size_t j = (i + 1 == size) ? 0 : i + 1;
+            sum += x[i] * y[j] - x[j] * y[i];
+        }
+        return sum / 2;
+    }
+
+    BoundingBox<double> box() const {
+        BoundingBox<double> b{x[0], y[0], x[0], y[0]};
+        for (size_t i = 1; i < size; ++i) {
+            b.expand(Point<double>(x[i], y[i]));
+        }
+        return b;
+    }
+
+    // Граница не пересекает и не касается сама себя. Совпадающие соседние вершины
+    // не мешают; вырожденный многоугольник (меньше трёх разных вершин или все на
+    // одной прямой) считается простым - его площадь равна нулю
+    bool isSimple(ShapeValidationStats &stats) const {
+        using Vertex = PredicatePoint<double>;
+        std::array<Vertex, maxVertices> v;
+        size_t n = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (n == 0 || v[n - 1].x != x[i] || v[n - 1].y != y[i])
+                v[n++] = {x[i], y[i]};
+        }
+        while (n > 1 && v[n - 1].x == v[0].x && v[n - 1].y == v[0].y) {
+            --n;
+        }
+        auto at = [&](size_t i) -> const Vertex & { return v[i % n]; };
+        bool flat = true;
+        for (size_t i = 2; i < n && flat; ++i) {
+            flat = orientSign(v[0], v[1], v[i], stats) == 0;
+        }
+        if (flat)
+            return true;
+
+        for (size_t i = 0; i < n; ++i) {
+            // Соседняя сторона не возвращается назад вдоль предыдущей
+            if (orientSign(at(i), at(i + 1), at(i + 2), stats) == 0 &&
+                (at(i + 2).x - at(i + 1).x) * (at(i + 1).x - at(i).x) + (at(i + 2).y - at(i + 1).y) * (at(i + 1).y - at(i).y) < 0)
+                return false;
+            for (size_t j = i + 2; j < n; ++j) {
+                if (i == 0 && j == n - 1)
+                    continue;
+                if (segmentsTouch(at(i), at(i + 1), at(j), at(j + 1), stats))
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Отсечение Сазерленда-Ходжмана: часть subject внутри выпуклого clip.
+// Обход clip может быть любым, направление учитывается по знаку площади.
+inline ConvexPolygon clipConvex(const ConvexPolygon &subject, const ConvexPolygon &clip) {
+    const double orientation = clip.areaSigned();
+    if (orientation == 0)
+        return {};
+    const double sign = orientation > 0 ? 1 : -1;
+
+    ConvexPolygon current = subject;
+    for (size_t e = 0; e < clip.size && current.size != 0; ++e) {
+        const size_t f = (e + 1 == clip.size) ? 0 : e + 1;
+        const double ax = clip.x[e], ay = clip.y[e];
+        const double dx = clip.x[f] - ax, dy = clip.y[f] - ay;
+        auto side = [&](double px, double py) { return sign * (dx * (py - ay) - dy * (px - ax)); };
+
+        ConvexPolygon next;
+        double prevSide = side(current.x[current.size - 1], current.y[current.size - 1]);
+        for (size_t i = 0, prev = current.size - 1; i < current.size; prev = i++) {
+            const double curSide = side(current.x[i], current.y[i]);
+            if ((curSide >= 0) != (prevSide >= 0)) {
+                const double t = prevSide / (prevSide - curSide);
+                next.push(current.x[prev] + t * (current.x[i] - current.x[prev]),
+                          current.y[prev] + t * (current.y[i] - current.y[prev]));
+            }
+            if (curSide >= 0)
+                next.push(current.x[i], current.y[i]);
+            prevSide = curSide;
+        }
+        current = next;
+    }
+    return current;
+}
+
+// Sweep-and-prune по x: вызывает onPair(i, j, chunk) для каждой пары с пересекающимися
+// прямоугольниками. Прямоугольники сортируются по minX, и для каждого просматриваются
+// только следующие, чей minX не дальше его maxX. Куски по options.chunkSize
+// прямоугольников в порядке сортировки обрабатываются параллельно; chunk - номер куска.
+template<class OnPair>
+void sweepBoxPairs(std::span<const BoundingBox<double>> boxes, const ReduceOptions &options, OnPair &&onPair) {
+    const size_t n = boxes.size();
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return boxes[a].minX < boxes[b].minX; });
+
+    parallelForChunks(n, options, [&](size_t begin, size_t end, size_t chunk) {
+        for (size_t s = begin; s < end; ++s) {
+            const size_t i = order[s];
+            for (size_t t = s + 1; t < n && boxes[order[t]].minX <= boxes[i].maxX; ++t) {
+                const size_t j = order[t];
+                if (boxes[i].intersects(boxes[j]))
+                    onPair(i, j, chunk);
+            }
+        }
+    });
+}
+
+// Кусок ребра между соседними событиями заметания: прямая y = slope * (x - origin) + base
+// на полосах [first, last). weight = +1 - нижняя граница фигуры, -1 - верхняя
+// (x0, y0) - левый конец ребра, по нему куски сравниваются по y без потери точности
+struct UnionEdgePiece {
+    double slope, base;
+    double x0, y0;
+    int weight;
+    uint32_t first, last;
+};
+
+// Активные куски в порядке y - декартово дерево (treap) с указателями на
+// родителя, чтобы удалять кусок по номеру узла. Глубина покрытия под куском -
+// сумма weight всех кусков ниже него. Ключ куска - глубина с внешней стороны:
+// под нижним куском, над верхним. Кусок лежит на границе объединения, если ключ
+// равен 0; узел хранит минимум ключа в поддереве (относительно начала поддерева)
+// и сумму прямых кусков, где он достигается: верхние со знаком +, нижние со
+// знаком -. В корне это длина сечения объединения как линейная функция x.
+class UnionSweepTree {
+  public:
+    explicit UnionSweepTree(std::span<const UnionEdgePiece> pieces, double origin) : pieces(pieces), origin(origin) {}
+
+    // Кусок piece, сравнение с остальными - по y в точке x внутри общей полосы
+    int32_t insert(uint32_t piece, double x) {
+        const int32_t v = static_cast<int32_t>(nodes.size());
+        Node node;
+        node.piece = piece;
+        // Приоритет - хеш номера куска: форма дерева, а с ней и порядок сложения,
+        // не зависят от потоков
+        node.priority = static_cast<uint32_t>((piece + 1) * 0x9E3779B97F4A7C15ull >> 32);
+        nodes.push_back(node);
+        pull(v);
+        const double y = yAt(piece, x);
+        auto [below, above] = split(root, [&](int32_t u) {
+            const double yu = yAt(nodes[u].piece, x);
+            if (yu != y)
+                return yu < y;
+            // Равные y: выше справа тот, у кого больше наклон; совпадающие - по номеру
+            const double su = pieces[nodes[u].piece].slope, s = pieces[piece].slope;
+            return su < s || (su == s && nodes[u].piece < piece);
+        });
+        root = merge(merge(below, v), above);
+        nodes[root].parent = -1;
+        return v;
+    }
+
+    void erase(int32_t v) {
+        const int32_t parent = nodes[v].parent;
+        const int32_t merged = merge(nodes[v].left, nodes[v].right);
+        if (merged >= 0)
+            nodes[merged].parent = parent;
+        if (parent < 0) {
+            root = merged;
+        } else {
+            (nodes[parent].left == v ? nodes[parent].left : nodes[parent].right) = merged;
+            for (int32_t u = parent; u >= 0; u = nodes[u].parent) {
+                pull(u);
+            }
+        }
+    }
+
+    // Длина сечения объединения вертикалью x внутри текущей полосы
+    double coveredLength(double x) const {
+        if (root < 0 || nodes[root].minKey != 0)
+            return 0;
+        return nodes[root].sumSlope * (x - origin) + nodes[root].sumBase;
+    }
+
+  private:
+    static constexpr int emptyKey = std::numeric_limits<int>::max();
+
+    struct Node {
+        int32_t left = -1, right = -1, parent = -1;
+        uint32_t priority = 0;
+        uint32_t piece = 0;
+        int total = 0;
+        int minKey = emptyKey;
+        double sumSlope = 0, sumBase = 0;
+    };
+
+    double yAt(uint32_t piece, double x) const { return pieces[piece].y0 + pieces[piece].slope * (x - pieces[piece].x0); }
+
+    void pull(int32_t v) {
+        Node &n = nodes[v];
+        const UnionEdgePiece &piece = pieces[n.piece];
+        int total = 0;
+        int minKey = emptyKey;
+        double sumSlope = 0, sumBase = 0;
+        auto take = [&](int key, double slope, double base) {
+            if (key < minKey) {
+                minKey = key;
+                sumSlope = sumBase = 0;
+            }
+            if (key == minKey) {
+                sumSlope += slope;
+                sumBase += base;
+            }
+        };
+        if (n.left >= 0) {
+            const Node &l = nodes[n.left];
+            take(l.minKey, l.sumSlope, l.sumBase);
+            total = l.total;
+            nodes[n.left].parent = v;
+        }
+        take(total + std::min(piece.weight, 0), -piece.weight * piece.slope, -piece.weight * piece.base);
+        total += piece.weight;
+        if (n.right >= 0) {
+            const Node &r = nodes[n.right];
+            take(total + r.minKey, r.sumSlope, r.sumBase);
+            total += r.total;
+            nodes[n.right].parent = v;
+        }
+        n.total = total;
+        n.minKey = minKey;
+        n.sumSlope = sumSlope;
+        n.sumBase = sumBase;
+    }
+
+    // Узлы, для которых isBelow истинно, и остальные
+    template<class IsBelow>
+    std::pair<int32_t, int32_t> split(int32_t v, const IsBelow &isBelow) {
+        if (v < 0)
+            return {-1, -1};
+        if (isBelow(v)) {
+            auto [below, above] = split(nodes[v].right, isBelow);
+            nodes[v].right = below;
+            pull(v);
+            return {v, above};
+        }
+        auto [below, above] = split(nodes[v].left, isBelow);
+        nodes[v].left = above;
+        pull(v);
+        return {below, v};
+    }
+
+    int32_t merge(int32_t a, int32_t b) {
+        if (a < 0 || b < 0)
+            return a < 0 ? b : a;
+        if (nodes[a].priority > nodes[b].priority) {
+            nodes[a].right = merge(nodes[a].right, b);
+            pull(a);
+            return a;
+        }
+        nodes[b].left = merge(a, nodes[b].left);
+        pull(b);
+        return b;
+    }
+
+    std::span<const UnionEdgePiece> pieces;
+    double origin;
+    std::vector<Node> nodes;
+    int32_t root = -1;
+};
+
+// Площадь объединения многоугольников (перекрытия считаются один раз).
+// Рёбра режутся в точках пересечения с рёбрами других фигур на куски, вертикали
+// через концы кусков делят плоскость на полосы. Внутри полосы куски не
+// пересекаются, поэтому заметающая прямая держит активные куски в
+// UnionSweepTree: каждое событие стоит O(log n), а длина сечения объединения в
+// полосе линейна по x и читается из корня. Пары рёбер берутся только у фигур с
+// пересекающимися прямоугольниками, всего O((n + k) log n), где k - число
+// пересечений рёбер.
+// Полосы делятся на куски по options.chunkSize и заметаются параллельно, каждый
+// со своим деревом; куски, которые пересекают начало полосы, готовятся одним
+// проходом. Многоугольники должны быть простыми, выпуклость не нужна. Для
+// самопересекающихся или с бесконечными и NaN координатами бросается
+// std::invalid_argument.
+inline double unionArea(std::span<const ConvexPolygon> polygons, const ReduceOptions &options = {}) {
+    const size_t n = polygons.size();
+    std::vector<BoundingBox<double>> boxes(n);
+    std::vector<uint32_t> edgeOffsets(n + 1, 0);
+    ShapeValidationStats stats;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = 0; k < polygons[i].size; ++k) {
+            if (!std::isfinite(polygons[i].x[k]) || !std::isfinite(polygons[i].y[k]))
+                throw std::invalid_argument("unionArea: координаты фигуры " + std::to_string(i) + " не конечны");
+        }
+        if (!polygons[i].isSimple(stats))
+            throw std::invalid_argument("unionArea: фигура " + std::to_string(i) + " самопересекается");
+        boxes[i] = polygons[i].box();
+        edgeOffsets[i + 1] = edgeOffsets[i] + static_cast<uint32_t>(polygons[i].size);
+    }
+
+    // События по x: вершины и пересечения рёбер соседних фигур. Пересечение
+    // запоминается за обоими рёбрами с одним и тем же x, чтобы их куски сошлись
+    std::vector<double> xs;
+    for (const auto &poly : polygons) {
+        xs.insert(xs.end(), poly.x.begin(), poly.x.begin() + poly.size);
+    }
+    ReduceOptions pairOptions{options.threads, 256};
+    std::vector<std::vector<std::pair<uint32_t, double>>> crossings((n + pairOptions.chunkSize - 1) /
+                                                                     pairOptions.chunkSize);
+    sweepBoxPairs(boxes, pairOptions, [&](size_t i, size_t j, size_t chunk) {
+        const ConvexPolygon &a = polygons[i], &b = polygons[j];
+        for (size_t p = 0; p < a.size; ++p) {
+            const size_t p1 = (p + 1 == a.size) ? 0 : p + 1;
+            const double ax = a.x[p], ay = a.y[p], adx = a.x[p1] - ax, ady = a.y[p1] - ay;
+            for (size_t q = 0; q < b.size; ++q) {
+                const size_t q1 = (q + 1 == b.size) ? 0 : q + 1;
+                const double bdx = b.x[q1] - b.x[q], bdy = b.y[q1] - b.y[q];
+                const double denom = adx * bdy - ady * bdx;
+                if (denom == 0)
+                    continue;
+                const double t = ((b.x[q] - ax) * bdy - (b.y[q] - ay) * bdx) / denom;
+                const double u = ((b.x[q] - ax) * ady - (b.y[q] - ay) * adx) / denom;
+                if (t > 0 && t < 1 && u > 0 && u < 1) {
+                    const double x = ax + t * adx;
+                    crossings[chunk].emplace_back(edgeOffsets[i] + p, x);
+                    crossings[chunk].emplace_back(edgeOffsets[j] + q, x);
+                }
+            }
+        }
+    });
+    std::vector<std::pair<uint32_t, double>> cuts;
+    for (const auto &part : crossings) {
+        cuts.insert(cuts.end(), part.begin(), part.end());
+        for (const auto &cut : part) {
+            xs.push_back(cut.second);
+        }
+    }
+    crossings = {};
+    std::sort(cuts.begin(), cuts.end());
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    if (xs.size() < 2)
+        return 0;
+    // Пересечения разных пар рёбер, совпадающие точно, считаются с ошибкой в
+    // несколько ulp. Полоса такой ширины упорядочила бы куски по шуму
+    // округления, и неверный порядок остался бы в дереве на следующих полосах,
+    // поэтому события ближе eventTolerance сливаются в первое из них
+    const double eventTolerance =
+        1e-10 * std::max({std::abs(xs.front()), std::abs(xs.back()), xs.back() - xs.front()});
+    xs.erase(std::unique(xs.begin(), xs.end(),
+                         [&](double kept, double next) { return next - kept <= eventTolerance; }),
+             xs.end());
+    if (xs.size() < 2)
+        return 0;
+    const double origin = (xs.front() + xs.back()) / 2;
+    // Каждое запрашиваемое x - одно из исходных событий, не меньше своего
+    // представителя и меньше следующего
+    auto eventIndex = [&](double x) {
+        return static_cast<uint32_t>(std::upper_bound(xs.begin(), xs.end(), x) - xs.begin() - 1);
+    };
+
+    // Куски рёбер слева направо. Внутренность фигуры слева от направления обхода
+    // против часовой стрелки, поэтому ребро, идущее вправо, - нижняя граница
+    std::vector<UnionEdgePiece> pieces;
+    auto cut = cuts.begin();
+    for (size_t i = 0; i < n; ++i) {
+        const ConvexPolygon &poly = polygons[i];
+        const double orientation = poly.areaSigned();
+        for (size_t p = 0; p < poly.size; ++p) {
+            const uint32_t edge = edgeOffsets[i] + static_cast<uint32_t>(p);
+            auto cutsEnd = cut;
+            while (cutsEnd != cuts.end() && cutsEnd->first == edge) {
+                ++cutsEnd;
+            }
+            const size_t p1 = (p + 1 == poly.size) ? 0 : p + 1;
+            double x0 = poly.x[p], y0 = poly.y[p], x1 = poly.x[p1], y1 = poly.y[p1];
+            if (orientation != 0 && x0 != x1) {
+                const int weight = ((x1 > x0) == (orientation > 0)) ? 1 : -1;
+                if (x1 < x0) {
+                    std::swap(x0, x1);
+                    std::swap(y0, y1);
+                }
+                const double slope = (y1 - y0) / (x1 - x0);
+                const double base = y0 + (origin - x0) * slope;
+                uint32_t first = eventIndex(x0);
+                const uint32_t edgeLast = eventIndex(x1);
+                for (auto c = cut; c <= cutsEnd; ++c) {
+                    // x пересечения считался по параметру другого ребра и может
+                    // на ulp выйти за концы этого
+                    const uint32_t last = c == cutsEnd ? edgeLast : std::min(edgeLast, eventIndex(c->second));
+                    if (last > first) {
+                        pieces.push_back({slope, base, x0, y0, weight, first, last});
+                        first = last;
+                    }
+                }
+            }
+            cut = cutsEnd;
+        }
+    }
+
+    // Номера кусков, которые начинаются и заканчиваются на каждом событии
+    const size_t numSlabs = xs.size() - 1;
+    std::vector<uint32_t> startOffsets(xs.size() + 1, 0), endOffsets(xs.size() + 1, 0);
+    for (const auto &piece : pieces) {
+        startOffsets[piece.first + 1]++;
+        endOffsets[piece.last + 1]++;
+    }
+    std::partial_sum(startOffsets.begin(), startOffsets.end(), startOffsets.begin());
+    std::partial_sum(endOffsets.begin(), endOffsets.end(), endOffsets.begin());
+    std::vector<uint32_t> startAt(pieces.size()), endAt(pieces.size());
+    {
+        std::vector<uint32_t> startFill(startOffsets.begin(), startOffsets.end() - 1);
+        std::vector<uint32_t> endFill(endOffsets.begin(), endOffsets.end() - 1);
+        for (uint32_t k = 0; k < pieces.size(); ++k) {
+            startAt[startFill[pieces[k].first]++] = k;
+            endAt[endFill[pieces[k].last]++] = k;
+        }
+    }
+
+    // Куски, которые пересекают начало каждой полосы-куска: first < begin < last
+    const size_t chunkSize = std::max<size_t>(1, options.chunkSize);
+    std::vector<std::vector<uint32_t>> startActive((numSlabs + chunkSize - 1) / chunkSize);
+    {
+        std::vector<uint32_t> active;
+        std::vector<size_t> position(pieces.size());
+        size_t event = 0;
+        for (size_t chunk = 0; chunk < startActive.size(); ++chunk) {
+            for (const size_t begin = chunk * chunkSize; event < begin; ++event) {
+                for (uint32_t k = endOffsets[event]; k < endOffsets[event + 1]; ++k) {
+                    const uint32_t piece = endAt[k];
+                    position[active.back()] = position[piece];
+                    active[position[piece]] = active.back();
+                    active.pop_back();
+                }
+                for (uint32_t k = startOffsets[event]; k < startOffsets[event + 1]; ++k) {
+                    position[startAt[k]] = active.size();
+                    active.push_back(startAt[k]);
+                }
+            }
+            // Закончившиеся ровно на начале куска
+            for (uint32_t k = endOffsets[event]; k < endOffsets[event + 1]; ++k) {
+                const uint32_t piece = endAt[k];
+                position[active.back()] = position[piece];
+                active[position[piece]] = active.back();
+                active.pop_back();
+            }
+            startActive[chunk] = active;
+            for (uint32_t k = endOffsets[event]; k < endOffsets[event + 1]; ++k) {
+                position[endAt[k]] = active.size();
+                active.push_back(endAt[k]);
+            }
+        }
+    }
+
+    CompensatedSum total = parallelReduce(numSlabs, options, CompensatedSum{},
+        [&](size_t begin, size_t end) {
+            UnionSweepTree tree(pieces, origin);
+            std::unordered_map<uint32_t, int32_t> nodeOf;
+            const double firstMid = (xs[begin] + xs[begin + 1]) / 2;
+            for (uint32_t piece : startActive[begin / chunkSize]) {
+                nodeOf[piece] = tree.insert(piece, firstMid);
+            }
+            CompensatedSum s;
+            for (size_t slab = begin; slab < end; ++slab) {
+                const double left = xs[slab], right = xs[slab + 1], mid = (left + right) / 2;
+                if (slab > begin) {
+                    for (uint32_t k = endOffsets[slab]; k < endOffsets[slab + 1]; ++k) {
+                        auto node = nodeOf.find(endAt[k]);
+                        tree.erase(node->second);
+                        nodeOf.erase(node);
+                    }
+                }
+                for (uint32_t k = startOffsets[slab]; k < startOffsets[slab + 1]; ++k) {
+                    nodeOf[startAt[k]] = tree.insert(startAt[k], mid);
+                }
+                s.add(tree.coveredLength(mid) * (right - left));
+            }
+            return s;
+        },
+        [](CompensatedSum a, const CompensatedSum &b) {
+            a.add(b);
+            return a;
+        });
+    return total.result();
+}
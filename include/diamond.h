@@ -3,22 +3,29 @@
 #include "figure.h"
 #include "point.h"
 #include <initializer_list>
+#include <utility>
 
 template<Scalar T>
 class Diamond : public Figure<T> {
   public:
-    Diamond() : Figure<T>(numOfPoints) {}
-    Diamond(const std::initializer_list<Point<T>> &t) : Figure<T>(t) {}
-    Diamond(const Diamond &other) : Figure<T>(other) {}
-    Diamond(Diamond &&other) : Figure<T>(other) {}
+    Diamond() : Figure<T>(vertices, numOfPoints) {}
+    Diamond(const std::initializer_list<Point<T>> &t) : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::assignPoints(t);
+    }
+    Diamond(const Diamond &other) noexcept : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::operator=(other);
+    }
+    Diamond(Diamond &&other) noexcept : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::operator=(std::move(other));
+    }
 
-    Diamond &operator=(const Diamond &other) {
+    Diamond &operator=(const Diamond &other) noexcept {
         Figure<T>::operator=(other);
         return *this;
     }
 
-    Diamond &operator=(Diamond &&other) {
-        Figure<T>::operator=(other);
+    Diamond &operator=(Diamond &&other) noexcept {
+        Figure<T>::operator=(std::move(other));
         return *this;
     }
     bool operator==(const Diamond &other) const {
@@ -26,6 +33,11 @@ class Diamond : public Figure<T> {
     }
 
     static constexpr int numOfPoints = 4;
+    static constexpr FigureKind figureKind = FigureKind::Diamond;
 
     int getNumOfPoints() const override { return numOfPoints; }
+    FigureKind getKind() const override { return figureKind; }
+
+  private:
+    Point<T> vertices[numOfPoints];
 };
\ No newline at end of file
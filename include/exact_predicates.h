@@ -0,0 +1,146 @@
+#pragma once
+
+#include "exact_rational.h"
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+
+// Точные знаки выражений по координатам: общие для проверки формы фигур
+// (shape_validation.h) и площади объединения (convex_polygon.h).
+
+// Сколько предикатов решено приближённым вычислением и сколько потребовали точного
+struct ShapeValidationStats {
+    size_t filteredPredicates = 0;
+    size_t exactPredicates = 0;
+
+    void add(const ShapeValidationStats &other) {
+        filteredPredicates += other.filteredPredicates;
+        exactPredicates += other.exactPredicates;
+    }
+};
+
+// Знак суммы sign * (a - b) * (c - d) по нескольким слагаемым - общий вид всех
+// предикатов проверки: ориентация тройки точек, параллельность сторон,
+// равенство квадратов длин.
+// Для целых координат (не шире 32 бит) сумма считается сразу точно в ExactInt.
+// Для вещественных сначала считается в double с оценкой погрешности по образцу
+// фильтров Шевчука; только если результат ближе к нулю, чем оценка, сумма
+// пересчитывается точно в виде разложения (expansion) на неперекрывающиеся double.
+// Предполагается, что произведения не переполняются и не уходят в денормалы.
+template<class C>
+struct DiffProduct {
+    C a, b, c, d;
+    int sign;
+};
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+// Преобразования без потерь: a + b = s + e, a * b = p + e
+inline void twoSum(double a, double b, double &s, double &e) {
+    s = a + b;
+    const double bv = s - a, av = s - bv;
+    e = (a - av) + (b - bv);
+}
+
+inline void twoProduct(double a, double b, double &p, double &e) {
+    p = a * b;
+    e = std::fma(a, b, -p);
+}
+
+template<size_t K>
+int exactSumSign(const std::array<DiffProduct<double>, K> &terms) {
+    // Разложение хранится по возрастанию модулей, нулевые компоненты выбрасываются
+    std::array<double, 8 * K + 1> expansion;
+    size_t length = 0;
+    auto grow = [&](double value) {
+        size_t kept = 0;
+        for (size_t i = 0; i < length; ++i) {
+            double error;
+            twoSum(value, expansion[i], value, error);
+            if (error != 0)
+                expansion[kept++] = error;
+        }
+        if (value != 0)
+            expansion[kept++] = value;
+        length = kept;
+    };
+    for (const auto &t : terms) {
+        double d1, e1, d2, e2;
+        twoSum(t.a, -t.b, d1, e1);
+        twoSum(t.c, -t.d, d2, e2);
+        for (double x : {d1, e1}) {
+            for (double y : {d2, e2}) {
+                double p, e;
+                twoProduct(x, y, p, e);
+                grow(t.sign * p);
+                grow(t.sign * e);
+            }
+        }
+    }
+    if (length == 0)
+        return 0;
+    return expansion[length - 1] > 0 ? 1 : -1;
+}
+
+template<size_t K>
+int sumSign(const std::array<DiffProduct<double>, K> &terms, ShapeValidationStats &stats) {
+    double sum = 0, sumAbs = 0;
+    for (const auto &t : terms) {
+        const double product = (t.a - t.b) * (t.c - t.d);
+        sum += t.sign * product;
+        sumAbs += std::fabs(product);
+    }
+    // Разности и произведение дают не больше 3 ulp на слагаемое, сложение - ещё K
+    const double bound = (K + 4) * DBL_EPSILON * sumAbs;
+    if (sum > bound || -sum > bound) {
+        stats.filteredPredicates++;
+        return sum > 0 ? 1 : -1;
+    }
+    stats.exactPredicates++;
+    return exactSumSign(terms);
+}
+
+#pragma GCC pop_options
+
+template<size_t K>
+int sumSign(const std::array<DiffProduct<ExactInt>, K> &terms, ShapeValidationStats &stats) {
+    ExactInt sum = 0;
+    for (const auto &t : terms) {
+        sum += t.sign * (t.a - t.b) * (t.c - t.d);
+    }
+    stats.exactPredicates++;
+    return (sum > 0) - (sum < 0);
+}
+
+// Точка в типе вычислений предикатов: ExactInt для целых координат, double иначе
+template<class C>
+struct PredicatePoint {
+    C x, y;
+};
+
+// Знак поворота a -> b -> c: 1 - против часовой стрелки, -1 - по ней, 0 - на одной прямой
+template<class C>
+int orientSign(const PredicatePoint<C> &a, const PredicatePoint<C> &b, const PredicatePoint<C> &c,
+               ShapeValidationStats &stats) {
+    return sumSign(std::array<DiffProduct<C>, 2>{{{b.x, a.x, c.y, a.y, 1}, {b.y, a.y, c.x, a.x, -1}}}, stats);
+}
+
+// Замкнутые отрезки ab и cd пересекаются или касаются
+template<class C>
+bool segmentsTouch(const PredicatePoint<C> &a, const PredicatePoint<C> &b, const PredicatePoint<C> &c,
+                   const PredicatePoint<C> &d, ShapeValidationStats &stats) {
+    // p на замкнутом отрезке ab при условии, что три точки на одной прямой
+    auto onSegment = [](const PredicatePoint<C> &a, const PredicatePoint<C> &b, const PredicatePoint<C> &p) {
+        return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) && std::min(a.y, b.y) <= p.y &&
+               p.y <= std::max(a.y, b.y);
+    };
+    const int o1 = orientSign(a, b, c, stats), o2 = orientSign(a, b, d, stats);
+    const int o3 = orientSign(c, d, a, stats), o4 = orientSign(c, d, b, stats);
+    if (o1 * o2 < 0 && o3 * o4 < 0)
+        return true;
+    return (o1 == 0 && onSegment(a, b, c)) || (o2 == 0 && onSegment(a, b, d)) || (o3 == 0 && onSegment(c, d, a)) ||
+           (o4 == 0 && onSegment(c, d, b));
+}
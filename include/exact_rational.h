@@ -0,0 +1,61 @@
+#pragma once
+
+#include "point.h"
+#include <type_traits>
+
+// 128-битное целое для точных сумм по целым координатам
+__extension__ typedef __int128 ExactInt;
+
+// Несократимая дробь numerator / denominator со знаменателем > 0.
+// У вырожденных величин (центр фигуры нулевой площади) знаменатель равен 0.
+struct ExactRational {
+    ExactInt numerator = 0;
+    ExactInt denominator = 1;
+
+    static constexpr ExactRational make(ExactInt numerator, ExactInt denominator) {
+        if (denominator < 0) {
+            numerator = -numerator;
+            denominator = -denominator;
+        }
+        ExactInt a = numerator < 0 ? -numerator : numerator, b = denominator;
+        while (b != 0) {
+            ExactInt t = a % b;
+            a = b;
+            b = t;
+        }
+        if (a > 1) {
+            numerator /= a;
+            denominator /= a;
+        }
+        return {numerator, denominator};
+    }
+
+    // Вещественный Out - ближайшее представимое значение, целый - округление до
+    // ближайшего (половины от нуля)
+    template<Scalar Out>
+    constexpr Out to() const {
+        if constexpr (std::is_floating_point_v<Out>) {
+            return static_cast<Out>(static_cast<long double>(numerator) / static_cast<long double>(denominator));
+        } else {
+            if (denominator == 0)
+                return Out{};
+            ExactInt q = numerator / denominator, r = numerator % denominator;
+            if (2 * (r < 0 ? -r : r) >= denominator)
+                q += numerator < 0 ? -1 : 1;
+            return static_cast<Out>(q);
+        }
+    }
+
+    bool operator==(const ExactRational &other) const = default;
+};
+
+struct ExactPoint {
+    ExactRational x, y;
+
+    template<Scalar Out>
+    constexpr Point<Out> to() const {
+        return Point<Out>(x.to<Out>(), y.to<Out>());
+    }
+
+    bool operator==(const ExactPoint &other) const = default;
+};
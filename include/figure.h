@@ -1,114 +1,243 @@
 #pragma once
 
+#include "affine.h"
+#include "bounding_box.h"
+#include "exact_rational.h"
 #include "point.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <initializer_list>
 #include <iostream>
-#include <memory>
-#include <vector>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
+enum class FigureKind : uint8_t { Trapezoid, Diamond, Pentagon };
+
+// Счётчики попаданий в кэш площади/центра/прямоугольника фигур (на поток).
+// Считаются, только если собрано с FIGURES_CACHE_STATS=1 (cmake
+// -DFIGURES_CACHE_STATS=ON, тесты включают всегда): иначе каждое чтение кэша
+// платило бы за обращение к thread_local
+#ifndef FIGURES_CACHE_STATS
+#define FIGURES_CACHE_STATS 0
+#endif
+
+struct FigureCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+// Вершины хранятся непосредственно в объекте-наследнике (массив на
+// numOfPoints точек), базовый класс видит их через span. Поэтому создание
+// и копирование фигуры не выделяют память в куче.
+// Площадь, центр и ограничивающий прямоугольник вычисляются лениво и кэшируются
+// до следующего изменения вершин (readPoints, присваивание, setPoint). Первое
+// обращение к кэшу записывает его, поэтому читать ещё не прогретую фигуру из
+// нескольких потоков нельзя (см. warmCache).
 template<Scalar T>
 class Figure {
   protected:
-    Figure() = default;
-    Figure(int numOfPoints) {
-        points.resize(numOfPoints);
-        for (int i = 0; i < numOfPoints; ++i) {
-            points[i] = std::make_unique<Point<T>>();
-        }
-    }
-    Figure(const std::initializer_list<Point<T>> &t) {
-        points.clear();
-        points.reserve(t.size());
-        for (const auto& p : t) {
-            points.push_back(std::make_unique<Point<T>>(p));
-        }
-    }
-    Figure(const Figure &other) {
-        points.clear();
-        points.reserve(other.points.size());
-        for (const auto& p : other.points) {
-            if (p)
-                points.push_back(std::make_unique<Point<T>>(*p));
-            else
-                points.push_back(nullptr);
-        }
+    // storage указывает на массив вершин наследника; значения он заполняет сам
+    Figure(Point<T> *storage, size_t numOfPoints) : points(storage, numOfPoints) {}
+    Figure(const Figure &other) = delete;
+    Figure &operator=(const Figure &other) noexcept {
+        if (this == &other)
+            return *this;
+
+        assert(points.size() == other.points.size());
+        std::copy(other.points.begin(), other.points.end(), points.begin());
+        cache = other.cache;
+        return *this;
     }
-    Figure(Figure &&other) noexcept = default;
-    Figure &operator=(const Figure &other) {
+    // Вершины лежат в самих объектах, поэтому перемещение переносит их поэлементно
+    // и ничего не выделяет; span points остаётся указывать на свой массив
+    Figure &operator=(Figure &&other) noexcept {
         if (this == &other)
             return *this;
-        
-        points.clear();
-        points.reserve(other.points.size());
-        for (const auto& p : other.points) {
-            if (p)
-                points.push_back(std::make_unique<Point<T>>(*p));
-            else
-                points.push_back(nullptr);
-        }
+
+        assert(points.size() == other.points.size());
+        std::move(other.points.begin(), other.points.end(), points.begin());
+        cache = other.cache;
         return *this;
     }
-    Figure &operator=(Figure &&other) = default;
+
+    // Список должен задавать все вершины, иначе std::invalid_argument и фигура не меняется
+    void assignPoints(const std::initializer_list<Point<T>> &t) {
+        if (t.size() != points.size())
+            throw std::invalid_argument("фигуре нужно " + std::to_string(points.size()) + " вершин, а не " +
+                                        std::to_string(t.size()));
+        std::copy(t.begin(), t.end(), points.begin());
+        invalidateCache();
+    }
 
     std::istream& read(std::istream &is) {
         return readPoints(is, getNumOfPoints());
     }
 
     std::istream& readPoints(std::istream &is, int pointNum) {
-        points.resize(pointNum);
+        assert(pointNum >= 0 && static_cast<size_t>(pointNum) <= points.size());
+        invalidateCache();
         for (int i = 0; i < pointNum; i++) {
-            points[i] = std::make_unique<Point<T>>();
-            is >> *points[i];
+            points[i] = Point<T>();
+            is >> points[i];
         }
         return is;
     }
 
   public:
-    bool operator==(const Figure &other) const {
-        if (points.size() != other.points.size()) return false;
-        for (size_t i = 0; i < points.size(); ++i) {
-            if (!points[i] || !other.points[i])
-                return false;
+    using value_type = T;
 
-            if (!(*points[i] == *other.points[i]))
-                return false;
-        }
-        return true;
+    bool operator==(const Figure &other) const {
+        return std::equal(points.begin(), points.end(), other.points.begin(), other.points.end());
     }
 
+    // Для целых T центр считается точно, как и площадь (см. calcGeometricCenterExact),
+    // в кэш попадает ближайшее double, результат - с отброшенной дробной частью
     Point<T> calcGeometricCenter() const {
-        double a = calcAreaSigned();
+        if (lookup(CenterValid)) {
+            return Point<T>(cache.centerX, cache.centerY);
+        }
         double cx = 0, cy = 0;
-        for (int i = 0; i < points.size(); i++) {
-            int j = (i + 1) % points.size();
-            double cross =
-                (*points[i])[0] * (*points[j])[1] - (*points[j])[0] * (*points[i])[1];
-            cx += ((*points[i])[0] + (*points[j])[0]) * cross;
-            cy += ((*points[i])[1] + (*points[j])[1]) * cross;
+        if constexpr (std::is_integral_v<T>) {
+            const ExactPoint exact = calcGeometricCenterExact();
+            cx = exact.x.template to<double>();
+            cy = exact.y.template to<double>();
+        } else {
+            double a = cachedAreaSigned();
+            const size_t n = points.size();
+            for (size_t i = 0; i < n; i++) {
+                size_t j = (i + 1 == n) ? 0 : i + 1;
+                double cross =
+                    points[i][0] * points[j][1] - points[j][0] * points[i][1];
+                cx += (points[i][0] + points[j][0]) * cross;
+                cy += (points[i][1] + points[j][1]) * cross;
+            }
+            cx /= (6 * a);
+            cy /= (6 * a);
         }
-        cx /= (6 * a);
-        cy /= (6 * a);
+        cache.centerX = cx;
+        cache.centerY = cy;
+        cache.valid |= CenterValid;
         return Point<T>(cx, cy);
     }
 
     double calcArea() const { return std::abs(calcAreaSigned()); }
 
+    // Удвоенная ориентированная площадь для целых T без плавающей точки, точна
+    // при |координатах| < 2^62
+    ExactInt calcDoubleAreaExact() const requires std::is_integral_v<T> {
+        ExactInt s = 0;
+        const size_t n = points.size();
+        for (size_t i = 0; i < n; i++) {
+            size_t j = (i + 1 == n) ? 0 : i + 1;
+            s += static_cast<ExactInt>(points[i][0]) * points[j][1] - static_cast<ExactInt>(points[j][0]) * points[i][1];
+        }
+        return s;
+    }
+
+    // Центр масс для целых T точными дробями, точен при |координатах| < 2^40
+    ExactPoint calcGeometricCenterExact() const requires std::is_integral_v<T> {
+        ExactInt a = 0, cx = 0, cy = 0;
+        const size_t n = points.size();
+        for (size_t i = 0; i < n; i++) {
+            size_t j = (i + 1 == n) ? 0 : i + 1;
+            ExactInt cross =
+                static_cast<ExactInt>(points[i][0]) * points[j][1] - static_cast<ExactInt>(points[j][0]) * points[i][1];
+            a += cross;
+            cx += (static_cast<ExactInt>(points[i][0]) + points[j][0]) * cross;
+            cy += (static_cast<ExactInt>(points[i][1]) + points[j][1]) * cross;
+        }
+        return {ExactRational::make(cx, 3 * a), ExactRational::make(cy, 3 * a)};
+    }
+
+    // Центр масс в выбранном типе. calcGeometricCenter возвращает Point<T> и для
+    // целых T отбрасывает дробную часть; здесь для целых T центр считается точно
+    // и округляется до ближайшего (или переводится в вещественный Out)
+    template<Scalar Out>
+    Point<Out> calcGeometricCenterAs() const {
+        if constexpr (std::is_integral_v<T>) {
+            return calcGeometricCenterExact().template to<Out>();
+        } else {
+            calcGeometricCenter();
+            return Point<Out>(static_cast<Out>(cache.centerX), static_cast<Out>(cache.centerY));
+        }
+    }
+
     double calcAreaSigned() const {
-        double s = 0;
-        for (size_t i = 0; i < points.size(); i++) {
-            size_t j = (i + 1) % points.size();
-            s += (*points[i])[0] * (*points[j])[1] - (*points[j])[0] * (*points[i])[1];
+        lookup(AreaValid);
+        return cachedAreaSigned();
+    }
+
+    BoundingBox<T> calcBoundingBox() const {
+        if (!lookup(BoxValid)) {
+            cache.box = BoundingBox<T>{points[0][0], points[0][1], points[0][0], points[0][1]};
+            for (const auto &p : points) {
+                cache.box.expand(p);
+            }
+            cache.valid |= BoxValid;
+        }
+        return cache.box;
+    }
+
+    const Point<T> &getPoint(size_t index) const { return points[index]; }
+
+    void setPoint(size_t index, const Point<T> &p) {
+        points[index] = p;
+        invalidateCache();
+    }
+
+    // Применяет m ко всем вершинам. Для вещественных T кэш не пересчитывается, а
+    // обновляется: площадь умножается на определитель, центр переносится тем же
+    // преобразованием, прямоугольник собирается по новым вершинам в том же проходе.
+    // Для целых T вершины округляются, поэтому кэш сбрасывается.
+    void transform(const Affine2 &m) {
+        if constexpr (!std::is_floating_point_v<T>) {
+            for (auto &p : points) {
+                p = m.apply(p);
+            }
+            invalidateCache();
+        } else {
+            points[0] = m.apply(points[0]);
+            BoundingBox<T> box{points[0][0], points[0][1], points[0][0], points[0][1]};
+            for (size_t i = 1; i < points.size(); i++) {
+                points[i] = m.apply(points[i]);
+                box.expand(points[i]);
+            }
+            cache.box = box;
+            cache.valid |= BoxValid;
+            if (cache.valid & AreaValid)
+                cache.areaSigned *= m.determinant();
+            if (cache.valid & CenterValid) {
+                Point<double> c = m.apply(Point<double>(cache.centerX, cache.centerY));
+                cache.centerX = c[0];
+                cache.centerY = c[1];
+            }
         }
+    }
+
+    // Заполняет кэш заранее, после этого фигуру можно читать из нескольких потоков
+    void warmCache() const {
+        calcGeometricCenter();
+        calcBoundingBox();
+    }
 
-        return s / 2;
+    void invalidateCache() { cache.valid = 0; }
+
+    static FigureCacheStats &cacheStats() {
+        thread_local FigureCacheStats stats;
+        return stats;
     }
 
+    std::span<const Point<T>> getPoints() const { return points; }
+
     explicit operator double() const { return calcArea(); }
 
     friend std::ostream &operator<<(std::ostream &os, const Figure &figure) {
         os << "Точки фигуры:\n";
-        for (int i = 0; i < figure.points.size(); i++) {
-            os << *figure.points[i] << ' ';
+        for (size_t i = 0; i < figure.points.size(); i++) {
+            os << figure.points[i] << ' ';
         }
         os << '\n';
         return os;
@@ -120,8 +249,47 @@ class Figure {
 
 
     virtual int getNumOfPoints() const = 0;
+    virtual FigureKind getKind() const = 0;
     
     virtual ~Figure() = default;
   private:
-    std::vector<std::unique_ptr<Point<T>>> points;
-};
\ No newline at end of file
+    enum : uint8_t { AreaValid = 1, CenterValid = 2, BoxValid = 4 };
+
+    bool lookup(uint8_t flag) const {
+        bool hit = cache.valid & flag;
+#if FIGURES_CACHE_STATS
+        auto &stats = cacheStats();
+        (hit ? stats.hits : stats.misses)++;
+#endif
+        return hit;
+    }
+
+    double cachedAreaSigned() const {
+        if (!(cache.valid & AreaValid)) {
+            if constexpr (std::is_integral_v<T>) {
+                cache.areaSigned = static_cast<double>(calcDoubleAreaExact()) / 2;
+                cache.valid |= AreaValid;
+                return cache.areaSigned;
+            }
+            double s = 0;
+            const size_t n = points.size();
+            for (size_t i = 0; i < n; i++) {
+                size_t j = (i + 1 == n) ? 0 : i + 1;
+                s += points[i][0] * points[j][1] - points[j][0] * points[i][1];
+            }
+            cache.areaSigned = s / 2;
+            cache.valid |= AreaValid;
+        }
+        return cache.areaSigned;
+    }
+
+    std::span<Point<T>> points;
+
+    struct Cache {
+        double areaSigned = 0;
+        double centerX = 0, centerY = 0;
+        BoundingBox<T> box;
+        uint8_t valid = 0;
+    };
+    mutable Cache cache;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "figures.h"
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// Создаёт фигуру (вместе с управляющим блоком shared_ptr) в памяти resource
+template<class F, class... Args>
+std::shared_ptr<F> allocateFigure(std::pmr::memory_resource *resource, Args &&...args) {
+    return std::allocate_shared<F>(std::pmr::polymorphic_allocator<F>(resource), std::forward<Args>(args)...);
+}
+
+// Монотонная арена для короткоживущего пакета фигур: всё выделенное через неё
+// освобождается одним шагом при release() или разрушении арены. Фигуры и
+// Figures, созданные в арене, не должны её переживать.
+class FigureArena {
+  public:
+    explicit FigureArena(size_t initialSize = 64 * 1024,
+                         std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        : buffer(initialSize, upstream) {}
+
+    FigureArena(const FigureArena &) = delete;
+    FigureArena &operator=(const FigureArena &) = delete;
+
+    template<class F, class... Args>
+    std::shared_ptr<F> makeFigure(Args &&...args) {
+        return allocateFigure<F>(&buffer, std::forward<Args>(args)...);
+    }
+
+    template<class F>
+    std::shared_ptr<F> makeFigure(const std::initializer_list<Point<typename F::value_type>> &points) {
+        return allocateFigure<F>(&buffer, points);
+    }
+
+    template<class U>
+    Figures<U> makeFigures(size_t capacity = 1) {
+        return Figures<U>(capacity, &buffer);
+    }
+
+    void release() { buffer.release(); }
+
+    std::pmr::memory_resource *resource() { return &buffer; }
+
+  private:
+    std::pmr::monotonic_buffer_resource buffer;
+};
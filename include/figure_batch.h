@@ -0,0 +1,312 @@
+#pragma once
+
+#include "affine.h"
+#include "figure.h"
+#include "figures.h"
+#include "point.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cassert>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Невладеющий взгляд на столбцы фигур с N вершинами: x[k][i] / y[k][i] - k-я вершина
+// i-й фигуры. Столбцы могут лежать в FigureColumns или прямо в отображённом файле.
+template<Scalar T, size_t N>
+struct FigureColumnsView {
+    std::array<const T *, N> x{};
+    std::array<const T *, N> y{};
+    size_t size = 0;
+
+    // Удвоенная ориентированная площадь каждой фигуры
+    void calcDoubleAreasSigned(double *out) const {
+        if constexpr (std::is_same_v<T, double>) {
+            activeShoelaceKernels<N>().doubleAreas(x.data(), y.data(), size, out);
+            return;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            double s = 0;
+            for (size_t k = 0; k < N; ++k) {
+                const size_t j = (k + 1 == N) ? 0 : k + 1;
+                s += static_cast<double>(x[k][i]) * y[j][i] - static_cast<double>(x[j][i]) * y[k][i];
+            }
+            out[i] = s;
+        }
+    }
+
+    // Суммы для центра масс: s = 2A, cx = sum (xi + xj) * cross, cy аналогично
+    void calcCentroidSums(double *s, double *cx, double *cy) const {
+        if constexpr (std::is_same_v<T, double>) {
+            activeShoelaceKernels<N>().centroidSums(x.data(), y.data(), size, s, cx, cy);
+            return;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            double a = 0, sx = 0, sy = 0;
+            for (size_t k = 0; k < N; ++k) {
+                const size_t j = (k + 1 == N) ? 0 : k + 1;
+                const double cross =
+                    static_cast<double>(x[k][i]) * y[j][i] - static_cast<double>(x[j][i]) * y[k][i];
+                a += cross;
+                sx += (static_cast<double>(x[k][i]) + x[j][i]) * cross;
+                sy += (static_cast<double>(y[k][i]) + y[j][i]) * cross;
+            }
+            s[i] = a;
+            cx[i] = sx;
+            cy[i] = sy;
+        }
+    }
+
+    // Площади и центры для float без перехода в double (см. FloatShoelaceKernels):
+    // вдвое шире вектор и вдвое меньше данных, точность держится сдвигом в первую
+    // вершину и компенсированным суммированием
+    void calcDoubleAreasFloat(float *out) const requires std::is_same_v<T, float> {
+        activeFloatShoelaceKernels<N>().doubleAreas(x.data(), y.data(), size, out);
+    }
+
+    void calcCentroidsFloat(float *s, float *cx, float *cy) const requires std::is_same_v<T, float> {
+        activeFloatShoelaceKernels<N>().centroids(x.data(), y.data(), size, s, cx, cy);
+    }
+
+    // Удвоенная ориентированная площадь для целых T не шире 32 бит: умножения и
+    // суммы в int64 по столбцам векторизуются без перевода в double. Точна при
+    // |координатах| < 2^29 (иначе см. Figure::calcDoubleAreaExact)
+    void calcDoubleAreasExact(int64_t *out) const requires(std::is_integral_v<T> && sizeof(T) <= 4) {
+        std::fill_n(out, size, 0);
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            const T *xk = x[k], *yk = y[k], *xj = x[j], *yj = y[j];
+            for (size_t i = 0; i < size; ++i) {
+                out[i] += static_cast<int64_t>(xk[i]) * yj[i] - static_cast<int64_t>(xj[i]) * yk[i];
+            }
+        }
+    }
+
+    Point<T> getPoint(size_t figure, size_t k) const { return Point<T>(x[k][figure], y[k][figure]); }
+};
+
+// Столбцовое (structure-of-arrays) хранилище фигур с одинаковым числом вершин:
+// k-я вершина всех фигур лежит подряд в xs[k] / ys[k], поэтому формула шнуровки
+// считается сразу для многих фигур без виртуальных вызовов.
+template<Scalar T, size_t N>
+class FigureColumns {
+  public:
+    static constexpr size_t numOfPoints = N;
+
+    void addFigure(std::span<const Point<T>> points, size_t index) {
+        assert(points.size() == N);
+        for (size_t k = 0; k < N; ++k) {
+            xs[k].push_back(points[k][0]);
+            ys[k].push_back(points[k][1]);
+        }
+        indices.push_back(index);
+    }
+
+    void reserve(size_t n) {
+        for (size_t k = 0; k < N; ++k) {
+            xs[k].reserve(n);
+            ys[k].reserve(n);
+        }
+        indices.reserve(n);
+    }
+
+    void calcDoubleAreasSigned(double *out) const { view().calcDoubleAreasSigned(out); }
+
+    void calcCentroidSums(double *s, double *cx, double *cy) const { view().calcCentroidSums(s, cx, cy); }
+
+    // Применяет m ко всем вершинам; для double - векторным ядром, куски по
+    // options.chunkSize фигур обрабатываются параллельно
+    void transform(const Affine2 &m, const ReduceOptions &options = {}) {
+        const double matrix[6] = {m.a, m.b, m.tx, m.c, m.d, m.ty};
+        parallelForChunks(getSize(), options, [&](size_t begin, size_t end, size_t) {
+            for (size_t k = 0; k < N; ++k) {
+                if constexpr (std::is_same_v<T, double>) {
+                    activeAffineKernel()(matrix, xs[k].data() + begin, ys[k].data() + begin, end - begin);
+                } else {
+                    for (size_t i = begin; i < end; ++i) {
+                        Point<T> p = m.apply(Point<T>(xs[k][i], ys[k][i]));
+                        xs[k][i] = p[0];
+                        ys[k][i] = p[1];
+                    }
+                }
+            }
+        });
+    }
+
+    FigureColumnsView<T, N> view() const {
+        FigureColumnsView<T, N> v;
+        for (size_t k = 0; k < N; ++k) {
+            v.x[k] = xs[k].data();
+            v.y[k] = ys[k].data();
+        }
+        v.size = getSize();
+        return v;
+    }
+
+    const T *x(size_t k) const { return xs[k].data(); }
+    const T *y(size_t k) const { return ys[k].data(); }
+
+    // Позиция каждой фигуры в исходной последовательности добавления
+    const std::vector<size_t> &getIndices() const { return indices; }
+
+    size_t getSize() const { return indices.size(); }
+
+  private:
+    std::array<std::vector<T>, N> xs;
+    std::array<std::vector<T>, N> ys;
+    std::vector<size_t> indices;
+};
+
+// Пакет фигур, сгруппированных по числу вершин: 4 (Trapezoid, Diamond) и 5 (Pentagon).
+// Результаты areas() и centroids() возвращаются в порядке добавления фигур.
+template<Scalar T>
+class FigureBatch {
+  public:
+    FigureBatch() = default;
+
+    template<class U>
+    explicit FigureBatch(const Figures<U> &figures) {
+        for (const auto &fig : figures) {
+            addFigure(Figures<U>::deref(fig));
+        }
+    }
+
+    // Фигуры с другим числом вершин не принимаются: std::invalid_argument
+    void addFigure(const Figure<T> &fig) {
+        auto points = fig.getPoints();
+        switch (points.size()) {
+        case 4:
+            quads.addFigure(points, size++);
+            break;
+        case 5:
+            pentagons.addFigure(points, size++);
+            break;
+        default:
+            throw std::invalid_argument("FigureBatch поддерживает только 4- и 5-угольники, а не " +
+                                        std::to_string(points.size()));
+        }
+    }
+
+    std::vector<double> areas() const {
+        std::vector<double> result(size);
+        scatterAreas(quads, result);
+        scatterAreas(pentagons, result);
+        return result;
+    }
+
+    std::vector<Point<T>> centroids() const {
+        std::vector<Point<T>> result(size);
+        scatterCentroids(quads, result);
+        scatterCentroids(pentagons, result);
+        return result;
+    }
+
+    // То же, что areas() и centroids(), но целиком в float
+    std::vector<float> areasFloat() const requires std::is_same_v<T, float> {
+        std::vector<float> result(size);
+        scatterFloat(quads, &result, nullptr);
+        scatterFloat(pentagons, &result, nullptr);
+        return result;
+    }
+
+    std::vector<Point<float>> centroidsFloat() const requires std::is_same_v<T, float> {
+        std::vector<Point<float>> result(size);
+        scatterFloat(quads, nullptr, &result);
+        scatterFloat(pentagons, nullptr, &result);
+        return result;
+    }
+
+    // Удвоенные ориентированные площади в порядке добавления (см. calcDoubleAreasExact)
+    std::vector<int64_t> doubleAreasExact() const requires(std::is_integral_v<T> && sizeof(T) <= 4) {
+        std::vector<int64_t> result(size);
+        scatterDoubleAreasExact(quads, result);
+        scatterDoubleAreasExact(pentagons, result);
+        return result;
+    }
+
+    double totalArea() const {
+        return sumAreas(quads) + sumAreas(pentagons);
+    }
+
+    void transform(const Affine2 &m, const ReduceOptions &options = {}) {
+        quads.transform(m, options);
+        pentagons.transform(m, options);
+    }
+
+    const FigureColumns<T, 4> &getQuads() const { return quads; }
+    const FigureColumns<T, 5> &getPentagons() const { return pentagons; }
+
+    size_t getSize() const { return size; }
+
+  private:
+    template<size_t N>
+    static void scatterAreas(const FigureColumns<T, N> &columns, std::vector<double> &out) {
+        std::vector<double> s(columns.getSize());
+        columns.calcDoubleAreasSigned(s.data());
+        const auto &indices = columns.getIndices();
+        for (size_t i = 0; i < s.size(); ++i) {
+            out[indices[i]] = std::abs(s[i] / 2);
+        }
+    }
+
+    template<size_t N>
+    static void scatterFloat(const FigureColumns<T, N> &columns, std::vector<float> *areas,
+                             std::vector<Point<float>> *centers) {
+        const size_t n = columns.getSize();
+        std::vector<float> s(n), cx, cy;
+        if (centers) {
+            cx.resize(n);
+            cy.resize(n);
+            columns.view().calcCentroidsFloat(s.data(), cx.data(), cy.data());
+        } else {
+            columns.view().calcDoubleAreasFloat(s.data());
+        }
+        const auto &indices = columns.getIndices();
+        for (size_t i = 0; i < n; ++i) {
+            if (areas)
+                (*areas)[indices[i]] = std::fabs(s[i] / 2);
+            if (centers)
+                (*centers)[indices[i]] = Point<float>(cx[i], cy[i]);
+        }
+    }
+
+    template<size_t N>
+    static void scatterDoubleAreasExact(const FigureColumns<T, N> &columns, std::vector<int64_t> &out) {
+        std::vector<int64_t> s(columns.getSize());
+        columns.view().calcDoubleAreasExact(s.data());
+        const auto &indices = columns.getIndices();
+        for (size_t i = 0; i < s.size(); ++i) {
+            out[indices[i]] = s[i];
+        }
+    }
+
+    template<size_t N>
+    static void scatterCentroids(const FigureColumns<T, N> &columns, std::vector<Point<T>> &out) {
+        const size_t n = columns.getSize();
+        std::vector<double> s(n), cx(n), cy(n);
+        columns.calcCentroidSums(s.data(), cx.data(), cy.data());
+        const auto &indices = columns.getIndices();
+        for (size_t i = 0; i < n; ++i) {
+            double a = s[i] / 2;
+            out[indices[i]] = Point<T>(cx[i] / (6 * a), cy[i] / (6 * a));
+        }
+    }
+
+    template<size_t N>
+    static double sumAreas(const FigureColumns<T, N> &columns) {
+        std::vector<double> s(columns.getSize());
+        columns.calcDoubleAreasSigned(s.data());
+        double total = 0;
+        for (double v : s) {
+            total += std::abs(v);
+        }
+        return total / 2;
+    }
+
+    FigureColumns<T, 4> quads;
+    FigureColumns<T, 5> pentagons;
+    size_t size = 0;
+};
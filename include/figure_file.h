@@ -0,0 +1,258 @@
+#pragma once
+
+#include "diamond.h"
+#include "figure.h"
+#include "figure_batch.h"
+#include "figures.h"
+#include "pentagon.h"
+#include "trapezoid.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Двоичный формат фигур (little-endian, версия 1):
+//   заголовок FigureFileHeader (40 байт);
+//   для каждого типа в порядке FigureKind (трапеции, ромбы, пятиугольники):
+//   N столбцов x, затем N столбцов y по counts[kind] чисел в каждом.
+// Каждый столбец начинается с границы figureFileAlignment байт, поэтому при
+// чтении через mmap на него можно смотреть как на массив T без копирования.
+
+constexpr uint16_t figureFileVersion = 1;
+constexpr size_t figureFileAlignment = 64;
+constexpr size_t figureKindCount = 3;
+constexpr size_t figureFileMaxColumns = 2 * Pentagon<int>::numOfPoints;
+
+struct FigureFileHeader {
+    char magic[4];
+    uint16_t version;
+    uint8_t scalarKind;   // 0 - знаковое целое, 1 - беззнаковое, 2 - с плавающей точкой
+    uint8_t scalarSize;
+    uint64_t counts[figureKindCount];
+    uint64_t columnsOffset;
+};
+static_assert(sizeof(FigureFileHeader) == 40);
+
+constexpr size_t numOfPointsOf(FigureKind kind) {
+    return kind == FigureKind::Pentagon ? Pentagon<int>::numOfPoints : Trapezoid<int>::numOfPoints;
+}
+
+template<Scalar T>
+constexpr uint8_t figureFileScalarKind() {
+    if constexpr (std::is_floating_point_v<T>)
+        return 2;
+    else if constexpr (std::is_unsigned_v<T>)
+        return 1;
+    else
+        return 0;
+}
+
+inline size_t alignFigureFileOffset(size_t offset) {
+    return (offset + figureFileAlignment - 1) / figureFileAlignment * figureFileAlignment;
+}
+
+// Смещения всех столбцов: offsets[kind][k] для x (k < N) и y (N + k)
+inline std::array<std::array<uint64_t, figureFileMaxColumns>, figureKindCount>
+figureFileColumnOffsets(const uint64_t (&counts)[figureKindCount], size_t scalarSize, uint64_t &end) {
+    std::array<std::array<uint64_t, figureFileMaxColumns>, figureKindCount> offsets{};
+    uint64_t offset = alignFigureFileOffset(sizeof(FigureFileHeader));
+    for (size_t kind = 0; kind < figureKindCount; ++kind) {
+        for (size_t c = 0; c < 2 * numOfPointsOf(static_cast<FigureKind>(kind)); ++c) {
+            offsets[kind][c] = offset;
+            offset = alignFigureFileOffset(offset + counts[kind] * scalarSize);
+        }
+    }
+    end = offset;
+    return offsets;
+}
+
+// Записывает коллекцию в двоичный файл; бросает std::runtime_error при ошибке
+template<class U>
+void writeFiguresBinary(const std::string &path, const Figures<U> &figures) {
+    using Fig = std::remove_cvref_t<decltype(Figures<U>::deref(std::declval<const U &>()))>;
+    using T = typename Fig::value_type;
+    if constexpr (std::endian::native != std::endian::little) {
+        throw std::runtime_error("двоичный формат фигур поддерживается только на little-endian");
+    }
+
+    FigureFileHeader header{};
+    std::memcpy(header.magic, "FIGB", 4);
+    header.version = figureFileVersion;
+    header.scalarKind = figureFileScalarKind<T>();
+    header.scalarSize = sizeof(T);
+
+    // columns[kind][c] - столбец c (сначала x, потом y) фигур данного типа
+    std::array<std::vector<std::vector<T>>, figureKindCount> columns;
+    for (size_t kind = 0; kind < figureKindCount; ++kind) {
+        columns[kind].resize(2 * numOfPointsOf(static_cast<FigureKind>(kind)));
+    }
+    for (const auto &item : figures) {
+        const auto &fig = Figures<U>::deref(item);
+        size_t kind = static_cast<size_t>(fig.getKind());
+        auto points = fig.getPoints();
+        const size_t n = points.size();
+        for (size_t k = 0; k < n; ++k) {
+            columns[kind][k].push_back(points[k][0]);
+            columns[kind][n + k].push_back(points[k][1]);
+        }
+        header.counts[kind]++;
+    }
+
+    uint64_t end = 0;
+    auto offsets = figureFileColumnOffsets(header.counts, sizeof(T), end);
+    header.columnsOffset = offsets[0][0];
+
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os)
+        throw std::runtime_error("не удалось открыть " + path + " для записи");
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    const char zeros[figureFileAlignment] = {};
+    for (size_t kind = 0; kind < figureKindCount; ++kind) {
+        for (size_t c = 0; c < columns[kind].size(); ++c) {
+            os.write(zeros, offsets[kind][c] - written);
+            os.write(reinterpret_cast<const char *>(columns[kind][c].data()), columns[kind][c].size() * sizeof(T));
+            written = offsets[kind][c] + columns[kind][c].size() * sizeof(T);
+        }
+    }
+    os.write(zeros, end - written);
+    if (!os)
+        throw std::runtime_error("ошибка записи " + path);
+}
+
+// Файл фигур, отображённый в память только для чтения. Столбцы и представления
+// FigureColumnsView указывают прямо в отображение и действительны, пока жив объект.
+template<Scalar T>
+class MappedFigureFile {
+  public:
+    explicit MappedFigureFile(const std::string &path) {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw std::runtime_error("двоичный формат фигур поддерживается только на little-endian");
+        }
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("не удалось открыть " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FigureFileHeader)) {
+            ::close(fd);
+            throw std::runtime_error(path + ": файл слишком короткий");
+        }
+        length = st.st_size;
+        void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+            throw std::runtime_error("не удалось отобразить " + path);
+        data = static_cast<const char *>(mapped);
+
+        try {
+            validate(path);
+        } catch (...) {
+            ::munmap(const_cast<char *>(data), length);
+            throw;
+        }
+    }
+
+    MappedFigureFile(const MappedFigureFile &) = delete;
+    MappedFigureFile &operator=(const MappedFigureFile &) = delete;
+
+    ~MappedFigureFile() { ::munmap(const_cast<char *>(data), length); }
+
+    const FigureFileHeader &getHeader() const { return *reinterpret_cast<const FigureFileHeader *>(data); }
+
+    size_t getCount(FigureKind kind) const { return getHeader().counts[static_cast<size_t>(kind)]; }
+
+    size_t getSize() const {
+        size_t total = 0;
+        for (size_t kind = 0; kind < figureKindCount; ++kind) {
+            total += getHeader().counts[kind];
+        }
+        return total;
+    }
+
+    std::span<const T> x(FigureKind kind, size_t k) const { return column(kind, k); }
+    std::span<const T> y(FigureKind kind, size_t k) const { return column(kind, numOfPointsOf(kind) + k); }
+
+    // Столбцы одного типа фигур; N должно совпадать с числом вершин этого типа
+    template<size_t N>
+    FigureColumnsView<T, N> view(FigureKind kind) const {
+        assert(N == numOfPointsOf(kind));
+        FigureColumnsView<T, N> v;
+        for (size_t k = 0; k < N; ++k) {
+            v.x[k] = x(kind, k).data();
+            v.y[k] = y(kind, k).data();
+        }
+        v.size = getCount(kind);
+        return v;
+    }
+
+    // Копия одной фигуры из отображения
+    template<class Fig>
+    Fig getFigure(size_t index) const {
+        Fig fig;
+        constexpr FigureKind kind = Fig::figureKind;
+        for (size_t k = 0; k < Fig::numOfPoints; ++k) {
+            fig.setPoint(k, Point<T>(x(kind, k)[index], y(kind, k)[index]));
+        }
+        return fig;
+    }
+
+    Figures<std::shared_ptr<Figure<T>>> toFigures() const {
+        Figures<std::shared_ptr<Figure<T>>> figures(std::max<size_t>(1, getSize()));
+        appendFigures<Trapezoid<T>>(figures);
+        appendFigures<Diamond<T>>(figures);
+        appendFigures<Pentagon<T>>(figures);
+        return figures;
+    }
+
+  private:
+    void validate(const std::string &path) {
+        const FigureFileHeader &header = getHeader();
+        if (std::memcmp(header.magic, "FIGB", 4) != 0)
+            throw std::runtime_error(path + ": это не файл фигур");
+        if (header.version != figureFileVersion)
+            throw std::runtime_error(path + ": неподдерживаемая версия " + std::to_string(header.version));
+        if (header.scalarKind != figureFileScalarKind<T>() || header.scalarSize != sizeof(T))
+            throw std::runtime_error(path + ": тип координат не совпадает с запрошенным");
+
+        // Столбец не длиннее файла, иначе произведение и суммы смещений могут
+        // переполниться и пройти проверку конца
+        const uint64_t maxCount = (length - sizeof(FigureFileHeader)) / sizeof(T);
+        for (size_t kind = 0; kind < figureKindCount; ++kind) {
+            if (header.counts[kind] > maxCount)
+                throw std::runtime_error(path + ": файл обрезан или повреждён");
+        }
+
+        uint64_t end = 0;
+        offsets = figureFileColumnOffsets(header.counts, sizeof(T), end);
+        if (end > length || header.columnsOffset != offsets[0][0])
+            throw std::runtime_error(path + ": файл обрезан или повреждён");
+    }
+
+    std::span<const T> column(FigureKind kind, size_t c) const {
+        size_t kindIndex = static_cast<size_t>(kind);
+        return {reinterpret_cast<const T *>(data + offsets[kindIndex][c]), getCount(kind)};
+    }
+
+    template<class Fig>
+    void appendFigures(Figures<std::shared_ptr<Figure<T>>> &figures) const {
+        constexpr FigureKind kind = Fig::figureKind;
+        for (size_t i = 0; i < getCount(kind); ++i) {
+            figures.addFigure(std::make_shared<Fig>(getFigure<Fig>(i)));
+        }
+    }
+
+    const char *data = nullptr;
+    size_t length = 0;
+    std::array<std::array<uint64_t, figureFileMaxColumns>, figureKindCount> offsets{};
+};
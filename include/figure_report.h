@@ -0,0 +1,268 @@
+#pragma once
+
+#include "figure.h"
+#include "point.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <functional>
+#include <ios>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+enum class ReportFormat { Text, Csv, JsonLines };
+
+// Какие величины попадают в отчёт
+enum ReportFields : unsigned {
+    ReportCenter = 1,
+    ReportArea = 2,
+    ReportCenterAndArea = ReportCenter | ReportArea,
+};
+
+// Пишет отчёт по фигурам в буфер вызывающего и сбрасывает его в приёмник крупными
+// кусками (когда набирается flushThreshold байт и в конце). Буфер очищается без
+// освобождения памяти, поэтому после первого заполнения выделений нет.
+// Text совпадает с выводом Figures::print*: при записи в std::ostream числа
+// форматируются по его precision() и флагам floatfield, uppercase и basefield
+// (showpos, showpoint, showbase и width не учитываются), с приёмником-функцией -
+// как поток по умолчанию. Csv и JsonLines пишут числа в кратчайшей форме,
+// которая читается обратно без потерь.
+class ReportWriter {
+  public:
+    using Sink = std::function<void(std::string_view)>;
+
+    ReportWriter(Sink sink, ReportFormat format, std::string &buffer, unsigned fields = ReportCenterAndArea,
+                 size_t flushThreshold = 1 << 16)
+        : sink(std::move(sink)), format(format), fields(fields), buffer(buffer), flushThreshold(flushThreshold) {
+        buffer.clear();
+        if (format == ReportFormat::Csv)
+            writeCsvHeader();
+    }
+
+    ReportWriter(std::ostream &os, ReportFormat format, std::string &buffer, unsigned fields = ReportCenterAndArea,
+                 size_t flushThreshold = 1 << 16)
+        : ReportWriter([&os](std::string_view chunk) { os.write(chunk.data(), chunk.size()); }, format, buffer,
+                       fields, flushThreshold) {
+        const std::ios_base::fmtflags flags = os.flags();
+        switch (flags & std::ios_base::floatfield) {
+        case std::ios_base::fixed:
+            textFloatFormat = std::chars_format::fixed;
+            break;
+        case std::ios_base::scientific:
+            textFloatFormat = std::chars_format::scientific;
+            break;
+        case std::ios_base::fixed | std::ios_base::scientific:
+            textFloatFormat = std::chars_format::hex;
+            break;
+        default:
+            textFloatFormat = std::chars_format::general;
+        }
+        textPrecision = static_cast<int>(std::max<std::streamsize>(0, os.precision()));
+        textUppercase = (flags & std::ios_base::uppercase) != 0;
+        textBase = (flags & std::ios_base::hex) ? 16 : (flags & std::ios_base::oct) ? 8 : 10;
+    }
+
+    ReportWriter(const ReportWriter &) = delete;
+    ReportWriter &operator=(const ReportWriter &) = delete;
+
+    ~ReportWriter() { flush(); }
+
+    template<Scalar T>
+    void writeFigure(size_t index, const Figure<T> &fig) {
+        switch (format) {
+        case ReportFormat::Text:
+            writeText(fig);
+            break;
+        case ReportFormat::Csv:
+            writeCsv(index, fig);
+            break;
+        case ReportFormat::JsonLines:
+            writeJson(index, fig);
+            break;
+        }
+        if (buffer.size() >= flushThreshold)
+            flush();
+    }
+
+    void flush() {
+        if (!buffer.empty()) {
+            sink(buffer);
+            buffer.clear();
+        }
+    }
+
+  private:
+    template<Scalar T>
+    void writeText(const Figure<T> &fig) {
+        buffer += "Точки фигуры:\n";
+        for (const auto &p : fig.getPoints()) {
+            writePoint(p);
+            buffer += ' ';
+        }
+        buffer += '\n';
+        if (fields & ReportCenter) {
+            buffer += "Геометрический центр: ";
+            writePoint(fig.calcGeometricCenter());
+            buffer += '\n';
+        }
+        if (fields & ReportArea) {
+            buffer += "Площадь фигуры: ";
+            writeNumber(fig.calcArea());
+            buffer += '\n';
+        }
+        buffer += '\n';
+    }
+
+    void writeCsvHeader() {
+        buffer += "index,kind";
+        if (fields & ReportCenter)
+            buffer += ",center_x,center_y";
+        if (fields & ReportArea)
+            buffer += ",area";
+        buffer += '\n';
+    }
+
+    template<Scalar T>
+    void writeCsv(size_t index, const Figure<T> &fig) {
+        writeNumber(index);
+        buffer += ',';
+        buffer += kindName(fig.getKind());
+        if (fields & ReportCenter) {
+            auto c = fig.calcGeometricCenter();
+            buffer += ',';
+            writeNumber(c[0]);
+            buffer += ',';
+            writeNumber(c[1]);
+        }
+        if (fields & ReportArea) {
+            buffer += ',';
+            writeNumber(fig.calcArea());
+        }
+        buffer += '\n';
+    }
+
+    template<Scalar T>
+    void writeJson(size_t index, const Figure<T> &fig) {
+        buffer += "{\"index\":";
+        writeNumber(index);
+        buffer += ",\"kind\":\"";
+        buffer += kindName(fig.getKind());
+        buffer += "\",\"points\":[";
+        bool first = true;
+        for (const auto &p : fig.getPoints()) {
+            if (!first)
+                buffer += ',';
+            first = false;
+            writeJsonPair(p[0], p[1]);
+        }
+        buffer += ']';
+        if (fields & ReportCenter) {
+            auto c = fig.calcGeometricCenter();
+            buffer += ",\"center\":";
+            writeJsonPair(c[0], c[1]);
+        }
+        if (fields & ReportArea) {
+            buffer += ",\"area\":";
+            writeJsonNumber(fig.calcArea());
+        }
+        buffer += "}\n";
+    }
+
+    template<Scalar T>
+    void writePoint(const Point<T> &p) {
+        buffer += '(';
+        writeNumber(p[0]);
+        buffer += ", ";
+        writeNumber(p[1]);
+        buffer += ')';
+    }
+
+    template<class V>
+    void writeJsonPair(V x, V y) {
+        buffer += '[';
+        writeJsonNumber(x);
+        buffer += ',';
+        writeJsonNumber(y);
+        buffer += ']';
+    }
+
+    // В JSON нет NaN и бесконечностей
+    template<class V>
+    void writeJsonNumber(V value) {
+        if constexpr (std::is_floating_point_v<V>) {
+            if (!std::isfinite(value)) {
+                buffer += "null";
+                return;
+            }
+        }
+        writeNumber(value);
+    }
+
+    // Text повторяет operator<< потока (см. textFloatFormat и соседние поля)
+    template<class V>
+    void writeNumber(V value) {
+        if (format != ReportFormat::Text) {
+            char digits[64];
+            buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+            return;
+        }
+        // fixed с большой точностью для 1e308 - больше 300 знаков
+        char digits[512];
+        char *begin = digits + 2;
+        char *end = begin;
+        if constexpr (std::is_floating_point_v<V>) {
+            if (textFloatFormat == std::chars_format::hex) {
+                // Как у потока: hexfloat без учёта precision и с префиксом 0x
+                bool negative = std::signbit(value) && !std::isnan(value);
+                end = std::to_chars(begin, digits + sizeof(digits), negative ? -value : value, textFloatFormat).ptr;
+                if (std::isfinite(value)) {
+                    *--begin = 'x';
+                    *--begin = '0';
+                }
+                if (negative)
+                    *--begin = '-';
+            } else {
+                auto result = std::to_chars(begin, digits + sizeof(digits), value, textFloatFormat, textPrecision);
+                if (result.ec != std::errc{})
+                    result = std::to_chars(begin, digits + sizeof(digits), value, std::chars_format::scientific,
+                                           std::min(textPrecision, 300));
+                end = result.ptr;
+            }
+        } else {
+            // Поток выводит отрицательные числа в hex и oct как беззнаковые
+            if (textBase != 10)
+                end = std::to_chars(begin, digits + sizeof(digits), static_cast<std::make_unsigned_t<V>>(value),
+                                    textBase).ptr;
+            else
+                end = std::to_chars(begin, digits + sizeof(digits), value).ptr;
+        }
+        if (textUppercase)
+            std::transform(begin, end, begin, [](char c) { return c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c; });
+        buffer.append(begin, end);
+    }
+
+    static std::string_view kindName(FigureKind kind) {
+        switch (kind) {
+        case FigureKind::Trapezoid:
+            return "trapezoid";
+        case FigureKind::Diamond:
+            return "diamond";
+        case FigureKind::Pentagon:
+            return "pentagon";
+        }
+        return "unknown";
+    }
+
+    Sink sink;
+    ReportFormat format;
+    // Форматирование Text; по умолчанию как у нового std::ostream (%g, 6 знаков)
+    std::chars_format textFloatFormat = std::chars_format::general;
+    int textPrecision = 6;
+    bool textUppercase = false;
+    int textBase = 10;
+    unsigned fields;
+    std::string &buffer;
+    size_t flushThreshold;
+};
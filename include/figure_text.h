@@ -0,0 +1,118 @@
+#pragma once
+
+#include "figure.h"
+#include "figures.h"
+#include "point.h"
+#include <charconv>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Ошибка разбора текста с фигурами; line и column считаются с 1
+class FigureParseError : public std::runtime_error {
+  public:
+    FigureParseError(const std::string &message, size_t line, size_t column)
+        : std::runtime_error(std::to_string(line) + ":" + std::to_string(column) + ": " + message),
+          line(line), column(column) {}
+
+    size_t getLine() const { return line; }
+    size_t getColumn() const { return column; }
+
+  private:
+    size_t line;
+    size_t column;
+};
+
+// Разбор чисел из буфера через std::from_chars, без локалей и потоков
+template<Scalar T>
+class CoordinateScanner {
+  public:
+    explicit CoordinateScanner(std::string_view text)
+        : current(text.data()), end(text.data() + text.size()), lineStart(text.data()) {}
+
+    // Пропускает пробельные символы; false, если текст закончился
+    bool skipSpace() {
+        while (current != end) {
+            char c = *current;
+            if (c == '\n') {
+                line++;
+                lineStart = current + 1;
+            } else if (c != ' ' && c != '\t' && c != '\r') {
+                return true;
+            }
+            current++;
+        }
+        return false;
+    }
+
+    T next() {
+        if (!skipSpace())
+            fail("неожиданный конец данных");
+        T value{};
+        auto [ptr, ec] = std::from_chars(current, end, value);
+        if (ec == std::errc::result_out_of_range)
+            fail("число вне диапазона");
+        if (ec != std::errc() || (ptr != end && !isSpace(*ptr)))
+            fail("ожидалось число");
+        current = ptr;
+        return value;
+    }
+
+    [[noreturn]] void fail(const std::string &message) const {
+        throw FigureParseError(message, line, static_cast<size_t>(current - lineStart) + 1);
+    }
+
+  private:
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    const char *current;
+    const char *end;
+    const char *lineStart;
+    size_t line = 1;
+};
+
+// Разбирает фигуры типа Fig в том же формате, что читает operator>>:
+// Fig::numOfPoints пар координат на фигуру через пробельные символы.
+// U - тип элементов Figures: сама фигура или shared_ptr на неё (или на Figure<T>).
+template<class Fig, class U>
+void parseFigures(std::string_view text, Figures<U> &out) {
+    using T = typename Fig::value_type;
+    CoordinateScanner<T> scanner(text);
+    while (scanner.skipSpace()) {
+        Fig fig;
+        for (size_t k = 0; k < Fig::numOfPoints; ++k) {
+            T x = scanner.next();
+            T y = scanner.next();
+            fig.setPoint(k, Point<T>(x, y));
+        }
+        if constexpr (std::is_same_v<U, Fig>)
+            out.addFigure(std::move(fig));
+        else
+            out.addFigure(std::make_shared<Fig>(std::move(fig)));
+    }
+}
+
+// Читает файл целиком в буфер и разбирает его одним проходом; бросает
+// std::runtime_error, если размер файла не узнать (например, это каталог) или
+// прочитано меньше него
+template<class Fig, class U = Fig>
+Figures<U> loadFigures(const std::string &path) {
+    std::ifstream is(path, std::ios::binary | std::ios::ate);
+    if (!is)
+        throw std::runtime_error("не удалось открыть " + path);
+    const std::streamoff size = is.tellg();
+    std::string buffer;
+    if (size < 0 || static_cast<unsigned long long>(size) >= buffer.max_size())
+        throw std::runtime_error("не удалось определить размер " + path);
+    buffer.resize(static_cast<size_t>(size));
+    is.seekg(0);
+    if (!is.read(buffer.data(), size))
+        throw std::runtime_error("ошибка чтения " + path);
+
+    Figures<U> figures;
+    parseFigures<Fig>(buffer, figures);
+    return figures;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "diamond.h"
+#include "figure_report.h"
+#include "pentagon.h"
+#include "point.h"
+#include "trapezoid.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+template<Scalar T>
+using FigureVariant = std::variant<Trapezoid<T>, Diamond<T>, Pentagon<T>>;
+
+// Замкнутый набор фигур без виртуальных вызовов: каждый тип лежит по значению в
+// своей однородной корзине, обход идёт по типам (сначала трапеции, затем ромбы,
+// затем пятиугольники), а тип известен на этапе компиляции.
+// Индексы в visit и deleteFigure считаются в этом же порядке.
+template<Scalar T>
+class VariantFigures {
+  public:
+    VariantFigures() = default;
+
+    void addFigure(Trapezoid<T> fig) { bucket<Trapezoid<T>>().push_back(std::move(fig)); }
+    void addFigure(Diamond<T> fig) { bucket<Diamond<T>>().push_back(std::move(fig)); }
+    void addFigure(Pentagon<T> fig) { bucket<Pentagon<T>>().push_back(std::move(fig)); }
+
+    void addFigure(FigureVariant<T> fig) {
+        std::visit([this](auto &&f) { addFigure(std::move(f)); }, std::move(fig));
+    }
+
+    void printCenterForEachFigure() const { printReport(ReportCenter); }
+
+    void printAreaForEachFigure() const { printReport(ReportArea); }
+
+    void printCenterAndAreaForEachFigure() const { printReport(ReportCenterAndArea); }
+
+    void writeReport(ReportWriter &writer) const {
+        size_t index = 0;
+        forEach([&](const auto &fig) { writer.writeFigure(index++, fig); });
+    }
+
+    double calcTotalArea() const {
+        double s = 0;
+        forEach([&s](const auto &fig) { s += fig.calcArea(); });
+        return s;
+    }
+
+    void deleteFigure(int index) {
+        if (index < 0 || static_cast<size_t>(index) >= getSize()) {
+          return;
+        }
+
+        size_t i = index;
+        std::apply([&i](auto &...b) { (eraseFrom(b, i) || ...); }, buckets);
+    }
+
+    // Вызывает f для фигуры с индексом index, тип фигуры передаётся статически
+    template<class F>
+    void visit(size_t index, F &&f) const {
+        std::apply([&](const auto &...b) { (visitIn(b, index, f) || ...); }, buckets);
+    }
+
+    template<class F>
+    void forEach(F &&f) const {
+        std::apply([&f](const auto &...b) {
+            (std::for_each(b.begin(), b.end(), f), ...);
+        }, buckets);
+    }
+
+    template<class Fig>
+    const std::vector<Fig> &getBucket() const { return std::get<std::vector<Fig>>(buckets); }
+
+    size_t getSize() const {
+        return std::apply([](const auto &...b) { return (b.size() + ...); }, buckets);
+    }
+
+  private:
+    void printReport(unsigned fields) const {
+        std::string buffer;
+        ReportWriter writer(std::cout, ReportFormat::Text, buffer, fields);
+        writeReport(writer);
+    }
+
+    template<class Fig>
+    std::vector<Fig> &bucket() { return std::get<std::vector<Fig>>(buckets); }
+
+    template<class Fig>
+    static bool eraseFrom(std::vector<Fig> &b, size_t &index) {
+        if (index >= b.size()) {
+            index -= b.size();
+            return false;
+        }
+        b.erase(b.begin() + index);
+        return true;
+    }
+
+    template<class Fig, class F>
+    static bool visitIn(const std::vector<Fig> &b, size_t &index, F &f) {
+        if (index >= b.size()) {
+            index -= b.size();
+            return false;
+        }
+        f(b[index]);
+        return true;
+    }
+
+    std::tuple<std::vector<Trapezoid<T>>, std::vector<Diamond<T>>, std::vector<Pentagon<T>>> buckets;
+};
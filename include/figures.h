@@ -1,64 +1,244 @@
 #pragma once
 
+#include "convex_polygon.h"
 #include "figure.h"
+#include "figure_report.h"
+#include "parallel_reduce.h"
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
 #include <vector>
 
+// Устойчивый дескриптор элемента Figures: остаётся действительным при удалении
+// других элементов и перестаёт совпадать после удаления своего (поколение слота).
+struct FigureHandle {
+    uint32_t slot = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+
+    bool operator==(const FigureHandle &other) const = default;
+};
+
+// Сводка по всем фигурам Figures, которую коллекция поддерживает при изменениях
+struct FigureAggregates {
+    size_t count = 0;
+    std::array<size_t, 3> kindCounts{};    // по FigureKind
+    double totalArea = 0;
+    Point<double> centroid;                // центр масс набора: центры фигур с весами-площадями
+    double minArea = 0;                    // для пустого набора 0
+    double maxArea = 0;
+};
+
 template <class T>
 class Figures {
   public:
     Figures() : Figures(1) {}
-    Figures(const size_t &n) : size(0), capacity(n) {
-        array = std::make_shared<T[]>(capacity);
+    Figures(const size_t &n) : Figures(n, std::pmr::get_default_resource()) {}
+    // Массив и служебные таблицы берут память из resource (например, из FigureArena)
+    Figures(const size_t &n, std::pmr::memory_resource *resource)
+        : size(0), capacity(n), resource(resource), slotToIndex(resource), indexToSlot(resource),
+          generations(resource), freeSlots(resource), areaBlocks(resource), dirtyIndices(resource) {
+        array = allocateArray(capacity);
+        indexToSlot.reserve(capacity);
+        slotToIndex.reserve(capacity);
+        generations.reserve(capacity);
+        areaBlocks.resize(areaBlockCount());
+    }
+
+    // Копия независима от оригинала и стоит O(n); дешёвые снимки - VersionedFigures.
+    // Для T = shared_ptr копируются указатели, сами фигуры остаются общими
+    Figures(const Figures &other)
+        : size(other.size), capacity(other.capacity), resource(other.resource),
+          slotToIndex(other.slotToIndex, resource), indexToSlot(other.indexToSlot, resource),
+          generations(other.generations, resource), freeSlots(other.freeSlots, resource),
+          areaBlocks(other.areaBlocks, resource), totalArea(other.totalArea), weightedX(other.weightedX), weightedY(other.weightedY),
+          kindCounts(other.kindCounts), dirtyIndices(other.dirtyIndices, resource),
+          aggregatesDirty(other.aggregatesDirty), staleUpdates(other.staleUpdates) {
+        array = allocateArray(capacity);
+        indexToSlot.reserve(capacity);
+        std::copy(other.array.get(), other.array.get() + size, array.get());
+    }
+
+    Figures(Figures &&other) noexcept = default;
+
+    Figures &operator=(const Figures &other) {
+        if (this != &other) {
+            Figures copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
     }
 
+    Figures &operator=(Figures &&other) noexcept = default;
+
     Figures(const std::initializer_list<std::shared_ptr<T>> &t) : Figures(t.size()) {
         for (const auto &fig : t) {
-            array[size++] = *fig;
+            addFigure(*fig);
         }
     }
 
     void printCenterForEachFigure() {
-      for (size_t i = 0; i < size; i++) {
-          std::cout << deref(array[i]) << "Геометрический центр: " << deref(array[i]).calcGeometricCenter() << "\n\n";
-      }
+      printReport(ReportCenter);
     }
 
     void addFigure(T fig) {
+        insertFigure(std::move(fig));
+    }
+
+    FigureHandle insertFigure(T fig) {
         if (size >= capacity) {
             resize();
         }
-        array[size++] = std::move(fig);
+        array[size] = std::move(fig);
+        indexToSlot.push_back(acquireSlot(size));
+        size++;
+        track(size - 1);
+        return handleAt(size - 1);
+    }
+
+    // Изменяет фигуру через f(T &) и обновляет сводку за O(log capacity)
+    template <class F>
+    void modifyFigure(size_t index, F &&f) {
+        if (index >= size)
+            return;
+        untrack(index);
+        f(array[index]);
+        track(index);
+    }
+
+    // Неконстантный доступ может изменить фигуру незаметно для сводки, поэтому
+    // запоминает позицию, и следующее изменение через Figures пересчитает её
+    // вклад (см. getAggregates). begin() и view() отдают весь массив и помечают
+    // устаревшей всю сводку.
+    // Для чтения - константный доступ, для изменения - modifyFigure
+    T &operator[](size_t index) {
+        markDirty(index);
+        return array[index];
     }
-    T operator[](size_t index) const{
+    const T &operator[](size_t index) const {
         return array[index];
     }
 
+    T *begin() {
+        markAllDirty();
+        return array.get();
+    }
+    T *end() { return array.get() + size; }
+    const T *begin() const { return array.get(); }
+    const T *end() const { return array.get() + size; }
+
+    std::span<T> view() {
+        markAllDirty();
+        return {array.get(), size};
+    }
+    std::span<const T> view() const { return {array.get(), size}; }
+
+    FigureHandle handleAt(size_t index) const {
+        uint32_t slot = indexToSlot[index];
+        return {slot, generations[slot]};
+    }
+
+    bool contains(FigureHandle handle) const {
+        return handle.slot < generations.size() && generations[handle.slot] == handle.generation &&
+               slotToIndex[handle.slot] != npos;
+    }
+
+    // Текущая позиция элемента или npos, если дескриптор устарел
+    size_t indexOf(FigureHandle handle) const {
+        return contains(handle) ? slotToIndex[handle.slot] : npos;
+    }
+
+    T *get(FigureHandle handle) {
+        size_t index = indexOf(handle);
+        if (index == npos)
+            return nullptr;
+        markDirty(index);
+        return &array[index];
+    }
+    const T *get(FigureHandle handle) const {
+        size_t index = indexOf(handle);
+        return index == npos ? nullptr : &array[index];
+    }
+
+    // Удаление за O(1): на место удалённого встаёт последний элемент
+    bool eraseFigure(FigureHandle handle) {
+        size_t index = indexOf(handle);
+        if (index == npos)
+            return false;
+        deleteFigureUnordered(index);
+        return true;
+    }
+
+    void deleteFigureUnordered(size_t index) {
+        if (index >= size) {
+          return;
+        }
+
+        releaseSlot(indexToSlot[index]);
+        untrack(index);
+        size_t last = size - 1;
+        if (index != last) {
+            array[index] = std::move(array[last]);
+            indexToSlot[index] = indexToSlot[last];
+            slotToIndex[indexToSlot[index]] = index;
+        }
+        array[last] = T();
+        indexToSlot.pop_back();
+        size--;
+        contribution(index) = contribution(last);
+        contribution(last) = Contribution{};
+        updateAreaTree(index);
+        updateAreaTree(last);
+        if (size == 0)
+            resetAggregates();
+    }
+
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
 
     void resize() {
         if (capacity <= 0) {
             capacity = 1;
         }
         capacity *= 2;
-        std::shared_ptr<T[]> tmp = std::make_shared<T[]>(capacity);
+        std::shared_ptr<T[]> tmp = allocateArray(capacity);
+        indexToSlot.reserve(capacity);
         for (size_t i = 0; i < size; ++i) {
             tmp[i] = std::move(array[i]);
         }
 
         array = std::move(tmp);
+
+        areaBlocks.resize(areaBlockCount());
+        rebuildAreaTree();
     }
 
     void printAreaForEachFigure() {
-      for (size_t i = 0; i < size; i++) {
-          std::cout << deref(array[i]) << "Площадь фигуры: " << deref(array[i]).calcArea() << "\n\n";
-      }
+      printReport(ReportArea);
     }
 
     void printCenterAndAreaForEachFigure() {
-      for (size_t i = 0; i < size; i++) {
-          std::cout << deref(array[i]) << "Геометрический центр: " << deref(array[i]).calcGeometricCenter() << '\n';
-          std::cout << "Площадь фигуры: " << deref(array[i]).calcArea() << "\n\n";
-      }
+      printReport(ReportCenterAndArea);
+    }
+
+    // Применяет m ко всем фигурам на нескольких потоках (см. Figure::transform).
+    // Если один объект лежит в массиве несколько раз через shared_ptr, результат не определён
+    void transform(const Affine2 &m, const ReduceOptions &options = {}) {
+        parallelForChunks(size, options, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                deref(array[i]).transform(m);
+            }
+        });
+        refreshAggregates();
+    }
+
+    // Отчёт по всем фигурам в формате и приёмник writer
+    void writeReport(ReportWriter &writer) const {
+        for (size_t i = 0; i < size; i++) {
+            writer.writeFigure(i, deref(array[i]));
+        }
     }
 
     double calcTotalArea() {
@@ -69,23 +249,177 @@ class Figures {
         return s;
     }
 
+    // Параллельные запросы: результат не зависит от options.threads
+    double calcTotalArea(const ReduceOptions &options) const {
+        CompensatedSum total = parallelReduce(size, options, CompensatedSum{},
+            [this](size_t begin, size_t end) {
+                CompensatedSum s;
+                for (size_t i = begin; i < end; i++) {
+                    s.add(deref(array[i]).calcArea());
+                }
+                return s;
+            },
+            [](CompensatedSum a, const CompensatedSum &b) {
+                a.add(b);
+                return a;
+            });
+        return total.result();
+    }
+
+    // Площадь объединения: перекрывающиеся части считаются один раз (см. unionArea).
+    // Фигуры должны быть простыми, иначе std::invalid_argument; результат не
+    // зависит от options.threads
+    double calcUnionArea(const ReduceOptions &options = {}) const {
+        std::vector<ConvexPolygon> polygons(size);
+        for (size_t i = 0; i < size; i++) {
+            polygons[i] = ConvexPolygon::from(deref(array[i]));
+        }
+        return unionArea(polygons, options);
+    }
+
+    // Для пустого массива возвращают 0
+    double calcMaxArea(const ReduceOptions &options = {}) const {
+        return size == 0 ? 0 : reduceArea(options, -std::numeric_limits<double>::infinity(),
+                                          [](double a, double b) { return std::max(a, b); });
+    }
+
+    double calcMinArea(const ReduceOptions &options = {}) const {
+        return size == 0 ? 0 : reduceArea(options, std::numeric_limits<double>::infinity(),
+                                          [](double a, double b) { return std::min(a, b); });
+    }
+
+    // bins равных корзин на [minArea, maxArea], значения за границами попадают в крайние
+    std::vector<size_t> calcAreaHistogram(size_t bins, double minArea, double maxArea,
+                                          const ReduceOptions &options = {}) const {
+        if (bins == 0)
+            return {};
+        const double width = (maxArea - minArea) / bins;
+        return parallelReduce(size, options, std::vector<size_t>(bins),
+            [&](size_t begin, size_t end) {
+                std::vector<size_t> counts(bins);
+                for (size_t i = begin; i < end; i++) {
+                    double bin = width > 0 ? (deref(array[i]).calcArea() - minArea) / width : 0;
+                    counts[static_cast<size_t>(std::clamp(bin, 0.0, static_cast<double>(bins - 1)))]++;
+                }
+                return counts;
+            },
+            [](std::vector<size_t> a, const std::vector<size_t> &b) {
+                for (size_t k = 0; k < a.size(); k++) {
+                    a[k] += b[k];
+                }
+                return a;
+            });
+    }
+
+    // Среднее геометрических центров всех фигур
+    Point<double> calcMeanCentroid(const ReduceOptions &options = {}) const {
+        struct Sums {
+            CompensatedSum x, y;
+        };
+        Sums sums = parallelReduce(size, options, Sums{},
+            [this](size_t begin, size_t end) {
+                Sums s;
+                for (size_t i = begin; i < end; i++) {
+                    auto c = deref(array[i]).calcGeometricCenter();
+                    s.x.add(c[0]);
+                    s.y.add(c[1]);
+                }
+                return s;
+            },
+            [](Sums a, const Sums &b) {
+                a.x.add(b.x);
+                a.y.add(b.y);
+                return a;
+            });
+        if (size == 0)
+            return Point<double>();
+        return Point<double>(sums.x.result() / size, sums.y.result() / size);
+    }
+
     void deleteFigure(int index) {
         if (index < 0 || index >= size) {
           return;
         }
 
+        releaseSlot(indexToSlot[index]);
+        untrack(index);
         for (size_t i = index; i < size - 1; i++) {
             array[i] = std::move(array[i + 1]);
+            indexToSlot[i] = indexToSlot[i + 1];
+            slotToIndex[indexToSlot[i]] = i;
         }
+        array[size - 1] = T();
+        indexToSlot.pop_back();
 
         size--;
+        // Сдвиг, как и в array, за O(n)
+        for (size_t i = index; i < size; i++) {
+            contribution(i) = contribution(i + 1);
+        }
+        contribution(size) = Contribution{};
+        rebuildAreaTree(index, size + 1);
+        if (size == 0)
+            resetAggregates();
+    }
+
+    // Сводка поддерживается при добавлении, удалении и modifyFigure. Вклад
+    // каждой позиции (площадь и площадь * центр) хранится и при удалении
+    // вычитается именно он, поэтому изменение фигуры в обход Figures (через
+    // shared_ptr) не накапливает ошибку: сводка просто не видит его до
+    // refreshAggregates. Суммы ведутся по Ноймайеру, минимум и максимум - в
+    // турнирном дереве над блоками по areaBlock позиций.
+    // Неконстантный доступ к позиции стоит следующему изменению O(log capacity)
+    // на её пересчёт. После begin() или view() (или если таких позиций
+    // накопилось больше size) изменения сводку не ведут, а пересчитывают её
+    // целиком раз в size изменений - O(1) в среднем.
+    // Актуальная сводка читается за O(1) без записи, поэтому безопасно из
+    // нескольких потоков. Устаревшая считается обходом за O(n), который
+    // заполняет кэши фигур (Figure::warmCache): из нескольких потоков её читать
+    // можно только после refreshAggregates или с прогретыми фигурами
+    FigureAggregates getAggregates() const {
+        if (isStale())
+            return scanAggregates();
+        FigureAggregates result;
+        result.count = size;
+        result.kindCounts = kindCounts;
+        result.totalArea = totalArea.result();
+        if (result.totalArea > 0)
+            result.centroid = Point<double>(weightedX.result() / result.totalArea, weightedY.result() / result.totalArea);
+        const AreaRange root = nodeRange(1);
+        if (root.min <= root.max) {
+            result.minArea = root.min;
+            result.maxArea = root.max;
+        }
+        return result;
+    }
+
+    double getTotalArea() const {
+        return isStale() ? scanAggregates().totalArea : totalArea.result();
+    }
+
+    // Пересчёт хранимой сводки за O(n)
+    void refreshAggregates() {
+        resetAggregates();
+        aggregatesDirty = false;
+        dirtyIndices.clear();
+        staleUpdates = 0;
+        for (size_t i = 0; i < size; i++) {
+            contribution(i) = contributionOf(i);
+            addContribution(i, 1, deref(array[i]).getKind());
+        }
+        for (size_t i = size; i < capacity; i++) {
+            contribution(i) = Contribution{};
+        }
+        rebuildAreaTree();
     }
     
     size_t getSize() const { return size; }
 
+    std::pmr::memory_resource *getResource() const { return resource; }
+
 
     template <typename U>
-    auto& deref(U& obj) {
+    static auto& deref(U& obj) {
         if constexpr (std::is_pointer_v<U> || requires { obj.operator->(); })
             return *obj;
         else
@@ -93,7 +427,261 @@ class Figures {
     }
 
   private:
+    struct Contribution {
+        double area = std::numeric_limits<double>::quiet_NaN();    // NaN - позиция пуста
+        double weightedX = 0, weightedY = 0;
+    };
+
+    // Диапазон площадей в поддереве; пустой - min > max
+    struct AreaRange {
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+
+        void add(double area) {
+            if (std::isnan(area))
+                return;
+            min = std::min(min, area);
+            max = std::max(max, area);
+        }
+    };
+
+    // Листья дерева - блоки позиций: узлов по одному на блок, а не на фигуру.
+    // Узел k лежит в одной таблице с вкладами блока k, чтобы рост массива не
+    // добавлял выделений
+    static constexpr size_t areaBlock = 4;
+
+    struct AreaBlock {
+        AreaRange node;
+        std::array<Contribution, areaBlock> items;
+    };
+
+    size_t areaBlockCount() const { return std::max<size_t>(1, (capacity + areaBlock - 1) / areaBlock); }
+
+    Contribution &contribution(size_t index) { return areaBlocks[index / areaBlock].items[index % areaBlock]; }
+    const Contribution &contribution(size_t index) const {
+        return areaBlocks[index / areaBlock].items[index % areaBlock];
+    }
+
+    Contribution contributionOf(size_t index) const {
+        const auto &fig = deref(array[index]);
+        Contribution c;
+        c.area = fig.calcArea();
+        // У вырожденной фигуры центр не определён, а вес всё равно нулевой
+        if (c.area > 0) {
+            auto center = fig.template calcGeometricCenterAs<double>();
+            c.weightedX = c.area * center[0];
+            c.weightedY = c.area * center[1];
+        }
+        return c;
+    }
+
+    // kind - вид фигуры, с которой вклад был посчитан
+    void addContribution(size_t index, int sign, FigureKind kind) {
+        const Contribution &c = contribution(index);
+        totalArea.add(sign * c.area);
+        weightedX.add(sign * c.weightedX);
+        weightedY.add(sign * c.weightedY);
+        kindCounts[static_cast<size_t>(kind)] += sign;
+    }
+
+    // Та же сводка обходом всех фигур, без записи
+    FigureAggregates scanAggregates() const {
+        FigureAggregates result;
+        CompensatedSum area, x, y;
+        AreaRange range;
+        for (size_t i = 0; i < size; i++) {
+            const Contribution c = contributionOf(i);
+            area.add(c.area);
+            x.add(c.weightedX);
+            y.add(c.weightedY);
+            range.add(c.area);
+            result.kindCounts[static_cast<size_t>(deref(array[i]).getKind())]++;
+        }
+        result.count = size;
+        result.totalArea = area.result();
+        if (result.totalArea > 0)
+            result.centroid = Point<double>(x.result() / result.totalArea, y.result() / result.totalArea);
+        if (range.min <= range.max) {
+            result.minArea = range.min;
+            result.maxArea = range.max;
+        }
+        return result;
+    }
+
+    bool isStale() const { return aggregatesDirty || !dirtyIndices.empty(); }
+
+    // Позиция, выданная неконстантным доступом. Вид фигуры запоминается сейчас:
+    // с ним посчитан хранимый вклад, а фигуру на позиции могут заменить
+    void markDirty(size_t index) {
+        if (aggregatesDirty)
+            return;
+        if (dirtyIndices.size() >= std::max<size_t>(size, 16)) {
+            markAllDirty();
+            return;
+        }
+        dirtyIndices.push_back({index, deref(array[index]).getKind()});
+    }
+
+    void markAllDirty() {
+        aggregatesDirty = true;
+        dirtyIndices.clear();
+    }
+
+    // Перед изменением через Figures: пересчитывает вклады запомненных позиций
+    // (для позиции берётся первая запись - с видом, под которым вклад учтён).
+    // false - сводка устарела целиком и это изменение её не ведёт
+    bool syncAggregates() {
+        if (aggregatesDirty) {
+            if (++staleUpdates < std::max<size_t>(size, 1))
+                return false;
+            refreshAggregates();
+            return true;
+        }
+        if (dirtyIndices.empty())
+            return true;
+        std::stable_sort(dirtyIndices.begin(), dirtyIndices.end(),
+                         [](const DirtyIndex &a, const DirtyIndex &b) { return a.index < b.index; });
+        for (size_t k = 0; k < dirtyIndices.size(); k++) {
+            const size_t index = dirtyIndices[k].index;
+            if (k > 0 && dirtyIndices[k - 1].index == index)
+                continue;
+            addContribution(index, -1, dirtyIndices[k].kind);
+            contribution(index) = contributionOf(index);
+            addContribution(index, 1, deref(array[index]).getKind());
+            updateAreaTree(index);
+        }
+        dirtyIndices.clear();
+        return true;
+    }
+
+    // track - после того, как фигура оказалась в array[index]. Полный пересчёт
+    // в syncAggregates уже учёл её
+    void track(size_t index) {
+        const bool wasStale = aggregatesDirty;
+        if (!syncAggregates() || wasStale)
+            return;
+        contribution(index) = contributionOf(index);
+        addContribution(index, 1, deref(array[index]).getKind());
+        updateAreaTree(index);
+    }
+
+    // До изменения или удаления: вычитается сохранённый вклад. Дерево обновляет вызывающий
+    void untrack(size_t index) {
+        if (syncAggregates())
+            addContribution(index, -1, deref(array[index]).getKind());
+    }
+
+    // Узел с номером >= areaBlockCount() - лист, блок позиций
+    AreaRange nodeRange(size_t node) const {
+        const size_t blocks = areaBlockCount();
+        if (node < blocks)
+            return areaBlocks[node].node;
+        AreaRange range;
+        for (const Contribution &c : areaBlocks[node - blocks].items) {
+            range.add(c.area);
+        }
+        return range;
+    }
+
+    AreaRange mergeChildren(size_t node) const {
+        const AreaRange a = nodeRange(2 * node), b = nodeRange(2 * node + 1);
+        return {std::min(a.min, b.min), std::max(a.max, b.max)};
+    }
+
+    // Путь от блока позиции index до корня
+    void updateAreaTree(size_t index) {
+        for (size_t node = (areaBlockCount() + index / areaBlock) / 2; node >= 1; node /= 2) {
+            areaBlocks[node].node = mergeChildren(node);
+        }
+    }
+
+    // Предки блоков с позициями [from, to). При числе блоков не степени двойки
+    // листья лежат на двух глубинах, поэтому диапазон узлов поднимается до
+    // корня, а не до первого узла 1: каждый узел пересчитывается после своих детей
+    void rebuildAreaTree(size_t from = 0, size_t to = npos) {
+        to = std::min(to, capacity);
+        if (from >= to)
+            return;
+        const size_t blocks = areaBlockCount();
+        size_t lo = (blocks + from / areaBlock) / 2, hi = (blocks + (to - 1) / areaBlock) / 2;
+        for (; hi >= 1; lo = std::max<size_t>(1, lo / 2), hi /= 2) {
+            for (size_t node = hi + 1; node-- > lo;) {
+                areaBlocks[node].node = mergeChildren(node);
+            }
+        }
+    }
+
+    void resetAggregates() {
+        totalArea = weightedX = weightedY = CompensatedSum{};
+        kindCounts = {};
+    }
+
+    void printReport(unsigned fields) const {
+        std::string buffer;
+        ReportWriter writer(std::cout, ReportFormat::Text, buffer, fields);
+        writeReport(writer);
+    }
+
+    template <class Pick>
+    double reduceArea(const ReduceOptions &options, double identity, Pick pick) const {
+        return parallelReduce(size, options, identity,
+            [&](size_t begin, size_t end) {
+                double r = identity;
+                for (size_t i = begin; i < end; i++) {
+                    r = pick(r, deref(array[i]).calcArea());
+                }
+                return r;
+            },
+            pick);
+    }
+
+    std::shared_ptr<T[]> allocateArray(size_t n) const {
+        return std::allocate_shared<T[]>(std::pmr::polymorphic_allocator<T>(resource), n);
+    }
+
+    uint32_t acquireSlot(size_t index) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(generations.size());
+            generations.push_back(0);
+            slotToIndex.push_back(npos);
+        }
+        slotToIndex[slot] = index;
+        return slot;
+    }
+
+    void releaseSlot(uint32_t slot) {
+        slotToIndex[slot] = npos;
+        generations[slot]++;
+        freeSlots.push_back(slot);
+    }
+
     std::shared_ptr<T[]> array;
     size_t size = 0;
     size_t capacity = 1;
+    std::pmr::memory_resource *resource;
+
+    // slot -> позиция в array и обратно, поколения слотов для FigureHandle
+    std::pmr::vector<size_t> slotToIndex;
+    std::pmr::vector<uint32_t> indexToSlot;
+    std::pmr::vector<uint32_t> generations;
+    std::pmr::vector<uint32_t> freeSlots;
+
+    // Сводка (см. getAggregates): вклады по позициям и внутренние узлы
+    // турнирного дерева, корень 1 (см. nodeRange)
+    std::pmr::vector<AreaBlock> areaBlocks;
+    CompensatedSum totalArea, weightedX, weightedY;
+    std::array<size_t, 3> kindCounts{};
+
+    // Позиции, выданные неконстантным доступом после последнего пересчёта
+    struct DirtyIndex {
+        size_t index;
+        FigureKind kind;
+    };
+    std::pmr::vector<DirtyIndex> dirtyIndices;
+    bool aggregatesDirty = false;    // устарела вся сводка
+    size_t staleUpdates = 0;         // изменений с тех пор, как она устарела
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "bounding_box.h"
+#include "diamond.h"
+#include "exact_rational.h"
+#include "figure.h"
+#include "pentagon.h"
+#include "point.h"
+#include "trapezoid.h"
+#include <array>
+#include <cassert>
+#include <initializer_list>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// Фигура фиксированного типа как значение без виртуальных функций: вершины в
+// std::array, все вычисления constexpr. Подходит для эталонных фигур, метрики
+// которых проверяются static_assert. Shape - Trapezoid, Diamond или Pentagon;
+// суммы по вершинам разворачиваются через index_sequence и считаются в том же
+// порядке, что и в Figure, поэтому результаты совпадают с Shape<T>.
+template<template<class> class Shape, Scalar T>
+class FixedShape {
+  public:
+    using value_type = T;
+    using figure_type = Shape<T>;
+    static constexpr size_t numOfPoints = figure_type::numOfPoints;
+    static constexpr FigureKind figureKind = figure_type::figureKind;
+
+    constexpr FixedShape() = default;
+
+    constexpr FixedShape(std::initializer_list<Point<T>> t) {
+        assert(t.size() == numOfPoints);
+        size_t i = 0;
+        for (const auto &p : t) {
+            points[i++] = p;
+        }
+    }
+
+    explicit FixedShape(const figure_type &fig) {
+        for (size_t i = 0; i < numOfPoints; ++i) {
+            points[i] = fig.getPoint(i);
+        }
+    }
+
+    // Обычная фигура с теми же вершинами
+    figure_type toFigure() const {
+        figure_type fig;
+        for (size_t i = 0; i < numOfPoints; ++i) {
+            fig.setPoint(i, points[i]);
+        }
+        return fig;
+    }
+
+    constexpr double calcAreaSigned() const { return static_cast<double>(sumCross(Indices{})) / 2; }
+
+    constexpr double calcArea() const {
+        double a = calcAreaSigned();
+        return a < 0 ? -a : a;
+    }
+
+    constexpr Point<T> calcGeometricCenter() const {
+        const auto [cx, cy] = sumCentroid(Indices{});
+        if constexpr (std::is_integral_v<T>) {
+            const Sum a = sumCross(Indices{});
+            return Point<T>(ExactRational::make(cx, 3 * a).template to<double>(),
+                            ExactRational::make(cy, 3 * a).template to<double>());
+        } else {
+            const double a = calcAreaSigned();
+            return Point<T>(cx / (6 * a), cy / (6 * a));
+        }
+    }
+
+    constexpr BoundingBox<T> calcBoundingBox() const {
+        BoundingBox<T> box{points[0][0], points[0][1], points[0][0], points[0][1]};
+        for (const auto &p : points) {
+            box.expand(p);
+        }
+        return box;
+    }
+
+    constexpr const Point<T> &getPoint(size_t index) const { return points[index]; }
+    constexpr void setPoint(size_t index, const Point<T> &p) { points[index] = p; }
+    constexpr std::span<const Point<T>> getPoints() const { return points; }
+
+    constexpr bool operator==(const FixedShape &other) const = default;
+
+  private:
+    using Indices = std::make_index_sequence<numOfPoints>;
+
+    static constexpr size_t next(size_t i) { return (i + 1 == numOfPoints) ? 0 : i + 1; }
+
+    // Те же выражения, что в Figure: для целых T точно в ExactInt, иначе
+    // произведение в T, сумма в double
+    using Sum = std::conditional_t<std::is_integral_v<T>, ExactInt, double>;
+
+    constexpr Sum cross(size_t i) const {
+        const size_t j = next(i);
+        if constexpr (std::is_integral_v<T>)
+            return static_cast<ExactInt>(points[i][0]) * points[j][1] - static_cast<ExactInt>(points[j][0]) * points[i][1];
+        else
+            return points[i][0] * points[j][1] - points[j][0] * points[i][1];
+    }
+
+    constexpr Sum coordSum(size_t i, size_t axis) const {
+        if constexpr (std::is_integral_v<T>)
+            return static_cast<ExactInt>(points[i][axis]) + points[next(i)][axis];
+        else
+            return points[i][axis] + points[next(i)][axis];
+    }
+
+    template<size_t... I>
+    constexpr Sum sumCross(std::index_sequence<I...>) const {
+        Sum s = 0;
+        ((s += cross(I)), ...);
+        return s;
+    }
+
+    template<size_t... I>
+    constexpr std::pair<Sum, Sum> sumCentroid(std::index_sequence<I...>) const {
+        Sum cx = 0, cy = 0;
+        ((cx += coordSum(I, 0) * cross(I), cy += coordSum(I, 1) * cross(I)), ...);
+        return {cx, cy};
+    }
+
+    std::array<Point<T>, numOfPoints> points{};
+};
+
+template<Scalar T>
+using FixedTrapezoid = FixedShape<Trapezoid, T>;
+template<Scalar T>
+using FixedDiamond = FixedShape<Diamond, T>;
+template<Scalar T>
+using FixedPentagon = FixedShape<Pentagon, T>;
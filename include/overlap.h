@@ -0,0 +1,58 @@
+#pragma once
+
+#include "convex_polygon.h"
+#include "figure.h"
+#include "figures.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Пара пересекающихся фигур коллекции (first < second) и площадь их пересечения
+struct FigureOverlap {
+    size_t first = 0;
+    size_t second = 0;
+    double area = 0;
+
+    bool operator==(const FigureOverlap &other) const = default;
+};
+
+// Площадь пересечения двух выпуклых фигур (0, если они только касаются)
+template<Scalar T>
+double intersectionArea(const Figure<T> &a, const Figure<T> &b) {
+    ConvexPolygon clipped = clipConvex(ConvexPolygon::from(a), ConvexPolygon::from(b));
+    return clipped.size < 3 ? 0 : std::abs(clipped.areaSigned());
+}
+
+// Все пары фигур коллекции с пересечением ненулевой площади, по возрастанию (first, second).
+// Широкая фаза - sweep-and-prune по x (sweepBoxPairs), узкая - точное отсечение
+// выпуклых многоугольников. Фигуры считаются выпуклыми.
+// options.chunkSize - число фигур (в порядке сортировки) на кусок; результат не
+// зависит от числа потоков.
+template<class U>
+std::vector<FigureOverlap> findOverlaps(const Figures<U> &figures, const ReduceOptions &options = {0, 256}) {
+    const size_t n = figures.getSize();
+    std::vector<BoundingBox<double>> boxes(n);
+    std::vector<ConvexPolygon> polygons(n);
+    for (size_t i = 0; i < n; ++i) {
+        polygons[i] = ConvexPolygon::from(Figures<U>::deref(figures[i]));
+        boxes[i] = polygons[i].box();
+    }
+
+    const size_t chunkSize = std::max<size_t>(1, options.chunkSize);
+    std::vector<std::vector<FigureOverlap>> partials((n + chunkSize - 1) / chunkSize);
+    sweepBoxPairs(boxes, options, [&](size_t i, size_t j, size_t chunk) {
+        ConvexPolygon clipped = clipConvex(polygons[i], polygons[j]);
+        double area = clipped.size < 3 ? 0 : std::abs(clipped.areaSigned());
+        if (area > 0)
+            partials[chunk].push_back({std::min(i, j), std::max(i, j), area});
+    });
+
+    std::vector<FigureOverlap> result;
+    for (auto &part : partials) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    std::sort(result.begin(), result.end(), [](const FigureOverlap &a, const FigureOverlap &b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+    return result;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Параметры параллельной редукции. Диапазон всегда режется на куски по chunkSize
+// элементов независимо от числа потоков, а частичные результаты объединяются
+// фиксированным попарным деревом, поэтому ответ побитово одинаков при любом threads.
+struct ReduceOptions {
+    size_t threads = 0;      // 0 - std::thread::hardware_concurrency()
+    size_t chunkSize = 1 << 14;
+};
+
+// Сумма Ноймайера (улучшенный Кэхэн)
+class CompensatedSum {
+  public:
+    void add(double value) {
+        double t = sum + value;
+        if (std::abs(sum) >= std::abs(value))
+            compensation += (sum - t) + value;
+        else
+            compensation += (value - t) + sum;
+        sum = t;
+    }
+
+    void add(const CompensatedSum &other) {
+        add(other.sum);
+        add(other.compensation);
+    }
+
+    double result() const { return sum + compensation; }
+
+  private:
+    double sum = 0;
+    double compensation = 0;
+};
+
+inline size_t resolveThreadCount(const ReduceOptions &options) {
+    if (options.threads != 0)
+        return options.threads;
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Вызывает body(begin, end, chunk) для каждого куска [begin, end) на нескольких потоках
+template<class Body>
+void parallelForChunks(size_t n, const ReduceOptions &options, Body &&body) {
+    const size_t chunkSize = std::max<size_t>(1, options.chunkSize);
+    const size_t numChunks = (n + chunkSize - 1) / chunkSize;
+    const size_t numThreads = std::min(resolveThreadCount(options), numChunks);
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t chunk = next++; chunk < numChunks; chunk = next++) {
+            size_t begin = chunk * chunkSize;
+            body(begin, std::min(n, begin + chunkSize), chunk);
+        }
+    };
+
+    if (numThreads <= 1) {
+        worker();
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(numThreads - 1);
+    for (size_t t = 1; t < numThreads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : pool) {
+        thread.join();
+    }
+}
+
+// mapChunk(begin, end) -> R считает кусок, combine(R, R) -> R объединяет соседние результаты
+template<class R, class MapChunk, class Combine>
+R parallelReduce(size_t n, const ReduceOptions &options, R identity, MapChunk &&mapChunk, Combine &&combine) {
+    const size_t chunkSize = std::max<size_t>(1, options.chunkSize);
+    std::vector<R> partials((n + chunkSize - 1) / chunkSize, identity);
+    parallelForChunks(n, options, [&](size_t begin, size_t end, size_t chunk) {
+        partials[chunk] = mapChunk(begin, end);
+    });
+
+    if (partials.empty())
+        return identity;
+    for (size_t step = 1; step < partials.size(); step *= 2) {
+        for (size_t i = 0; i + step < partials.size(); i += 2 * step) {
+            partials[i] = combine(partials[i], partials[i + step]);
+        }
+    }
+    return partials[0];
+}
@@ -3,27 +3,39 @@
 #include "figure.h"
 #include "point.h"
 #include <initializer_list>
+#include <utility>
 
 template<Scalar T>
 class Pentagon : public Figure<T> {
   public:
-    Pentagon() : Figure<T>(numOfPoints) {}
-    Pentagon(const std::initializer_list<Point<T>> &t) : Figure<T>(t) {}
-    Pentagon(const Pentagon &other) : Figure<T>(other) {}
-    Pentagon(Pentagon &&other) : Figure<T>(other) {}
-    Pentagon &operator=(const Pentagon &other) {
+    Pentagon() : Figure<T>(vertices, numOfPoints) {}
+    Pentagon(const std::initializer_list<Point<T>> &t) : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::assignPoints(t);
+    }
+    Pentagon(const Pentagon &other) noexcept : Figure<T>(vertices, numOfPoints) {
         Figure<T>::operator=(other);
-        return *this;
     }
-    Pentagon &operator=(Pentagon &&other) {
+    Pentagon(Pentagon &&other) noexcept : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::operator=(std::move(other));
+    }
+    Pentagon &operator=(const Pentagon &other) noexcept {
         Figure<T>::operator=(other);
         return *this;
     }
+    Pentagon &operator=(Pentagon &&other) noexcept {
+        Figure<T>::operator=(std::move(other));
+        return *this;
+    }
     bool operator==(const Pentagon &other) const {
         return Figure<T>::operator==(other);
     }
 
     static constexpr int numOfPoints = 5;
+    static constexpr FigureKind figureKind = FigureKind::Pentagon;
 
     int getNumOfPoints() const override { return numOfPoints; }
+    FigureKind getKind() const override { return figureKind; }
+
+  private:
+    Point<T> vertices[numOfPoints];
 };
\ No newline at end of file
@@ -12,14 +12,14 @@ concept Scalar = std::is_scalar_v<T>;
 template<Scalar T>
 class Point {
     public:
-        Point() : x(0), y(0) {}
-        Point(T x, T y) : x(x), y(y) {}
+        constexpr Point() : x(0), y(0) {}
+        constexpr Point(T x, T y) : x(x), y(y) {}
 
-        T& operator[](size_t index) {
+        constexpr T& operator[](size_t index) {
             assert((index == 0) || (index == 1));
             return (index == 0) ? x : y;
         }
-        T operator[](size_t index) const{
+        constexpr T operator[](size_t index) const{
             assert((index == 0) || (index == 1));
             return (index == 0) ? x : y;
         }
@@ -33,7 +33,7 @@ class Point {
             return os;
         }
 
-        bool operator==(const Point &other) const {
+        constexpr bool operator==(const Point &other) const {
             return x == other.x && y == other.y;
         }
     
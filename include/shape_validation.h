@@ -0,0 +1,185 @@
+#pragma once
+
+#include "exact_predicates.h"
+#include "exact_rational.h"
+#include "figure.h"
+#include "figures.h"
+#include "parallel_reduce.h"
+#include "point.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Причины, по которым фигура не соответствует своему виду (битовые флаги)
+enum ShapeDefect : uint8_t {
+    ShapeNonFinite = 1,            // NaN или бесконечность в координатах, остальное не проверяется
+    ShapeRepeatedVertex = 2,       // соседние вершины совпадают
+    ShapeCollinearCorner = 4,      // три соседние вершины на одной прямой (в том числе нулевая площадь)
+    ShapeNotConvex = 8,            // повороты в вершинах разного знака
+    ShapeSelfIntersecting = 16,    // несмежные стороны пересекаются или касаются
+    ShapeNoParallelSides = 32,     // у трапеции нет пары параллельных сторон, ромб - не параллелограмм
+    ShapeUnequalSides = 64,        // стороны ромба не равны
+};
+
+// Проверка одной фигуры по её виду (getKind). Допустимая фигура простая,
+// строго выпуклая и без совпадающих соседних вершин, поэтому её площадь не
+// равна нулю. Результат - объединение флагов ShapeDefect, 0 - фигура допустима
+template<Scalar T>
+    requires(!std::is_integral_v<T> || sizeof(T) <= 4)
+uint8_t validateShape(const Figure<T> &fig, ShapeValidationStats &stats) {
+    using C = std::conditional_t<std::is_integral_v<T>, ExactInt, double>;
+    using Vertex = PredicatePoint<C>;
+
+    const auto points = fig.getPoints();
+    const size_t n = points.size();
+    std::array<Vertex, 8> v;
+    for (size_t i = 0; i < n; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (!std::isfinite(points[i][0]) || !std::isfinite(points[i][1]))
+                return ShapeNonFinite;
+        }
+        v[i] = {static_cast<C>(points[i][0]), static_cast<C>(points[i][1])};
+    }
+    auto at = [&](size_t i) -> const Vertex & { return v[i % n]; };
+
+    auto orient = [&](const Vertex &a, const Vertex &b, const Vertex &c) { return orientSign(a, b, c, stats); };
+    // Векторное произведение сторон (p, q) и (r, s)
+    auto crossSign = [&](const Vertex &p, const Vertex &q, const Vertex &r, const Vertex &s) {
+        return sumSign(std::array<DiffProduct<C>, 2>{{{q.x, p.x, s.y, r.y, 1}, {q.y, p.y, s.x, r.x, -1}}}, stats);
+    };
+    // |pq|^2 - |rs|^2
+    auto lengthCompare = [&](const Vertex &p, const Vertex &q, const Vertex &r, const Vertex &s) {
+        return sumSign(std::array<DiffProduct<C>, 4>{{{q.x, p.x, q.x, p.x, 1}, {q.y, p.y, q.y, p.y, 1},
+                                                      {s.x, r.x, s.x, r.x, -1}, {s.y, r.y, s.y, r.y, -1}}},
+                       stats);
+    };
+
+    uint8_t defects = 0;
+    int positive = 0, negative = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (at(i).x == at(i + 1).x && at(i).y == at(i + 1).y)
+            defects |= ShapeRepeatedVertex;
+        const int turn = orient(at(i), at(i + 1), at(i + 2));
+        if (turn == 0)
+            defects |= ShapeCollinearCorner;
+        positive += turn > 0;
+        negative += turn < 0;
+    }
+    if (positive != 0 && negative != 0)
+        defects |= ShapeNotConvex;
+
+    // Несмежные стороны i и j
+    for (size_t i = 0; i < n && !(defects & ShapeSelfIntersecting); ++i) {
+        for (size_t j = i + 2; j < n; ++j) {
+            if (i == 0 && j == n - 1)
+                continue;
+            if (segmentsTouch(at(i), at(i + 1), at(j), at(j + 1), stats)) {
+                defects |= ShapeSelfIntersecting;
+                break;
+            }
+        }
+    }
+
+    if (n == 4) {
+        const bool parallel01 = crossSign(at(0), at(1), at(3), at(2)) == 0;
+        const bool parallel12 = crossSign(at(1), at(2), at(0), at(3)) == 0;
+        switch (fig.getKind()) {
+        case FigureKind::Trapezoid:
+            if (!parallel01 && !parallel12)
+                defects |= ShapeNoParallelSides;
+            break;
+        case FigureKind::Diamond:
+            if (!parallel01 || !parallel12)
+                defects |= ShapeNoParallelSides;
+            for (size_t i = 0; i < 3; ++i) {
+                if (lengthCompare(at(i), at(i + 1), at(i + 1), at(i + 2)) != 0) {
+                    defects |= ShapeUnequalSides;
+                    break;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return defects;
+}
+
+// Результат пакетной проверки: флаги ShapeDefect каждой фигуры и битовая карта
+// допустимых (бит i - фигура i без дефектов)
+class ShapeValidationResult {
+  public:
+    ShapeValidationResult() = default;
+    explicit ShapeValidationResult(size_t numFigures) : defects(numFigures), validBits((numFigures + 63) / 64) {}
+
+    bool isValid(size_t figure) const { return (validBits[figure / 64] >> (figure % 64)) & 1; }
+    uint8_t getDefects(size_t figure) const { return defects[figure]; }
+
+    std::span<const uint64_t> getValidBits() const { return validBits; }
+    std::span<const uint8_t> getAllDefects() const { return defects; }
+
+    size_t countValid() const {
+        size_t count = 0;
+        for (uint64_t word : validBits) {
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+    // Номера фигур с дефектами по возрастанию
+    std::vector<uint32_t> invalidFigures() const {
+        std::vector<uint32_t> out;
+        for (size_t i = 0; i < defects.size(); ++i) {
+            if (defects[i] != 0)
+                out.push_back(static_cast<uint32_t>(i));
+        }
+        return out;
+    }
+
+    size_t getSize() const { return defects.size(); }
+    const ShapeValidationStats &getStats() const { return stats; }
+
+    // Из разных потоков - только для фигур из разных слов битовой карты
+    void setDefects(size_t figure, uint8_t value) {
+        defects[figure] = value;
+        const uint64_t bit = uint64_t{1} << (figure % 64);
+        validBits[figure / 64] = value == 0 ? (validBits[figure / 64] | bit) : (validBits[figure / 64] & ~bit);
+    }
+
+    void setStats(const ShapeValidationStats &value) { stats = value; }
+
+  private:
+    std::vector<uint8_t> defects;
+    std::vector<uint64_t> validBits;
+    ShapeValidationStats stats;
+};
+
+// Проверяет все фигуры на нескольких потоках. options.chunkSize - число фигур в
+// куске, округляется вверх до кратного 64, чтобы слова битовой карты не делились
+// между потоками
+template<class U>
+ShapeValidationResult validateShapes(const Figures<U> &figures, const ReduceOptions &options = {0, 1024}) {
+    const size_t n = figures.getSize();
+    ShapeValidationResult result(n);
+    ReduceOptions aligned = options;
+    aligned.chunkSize = (std::max<size_t>(1, options.chunkSize) + 63) / 64 * 64;
+    result.setStats(parallelReduce(n, aligned, ShapeValidationStats{},
+        [&](size_t begin, size_t end) {
+            ShapeValidationStats stats;
+            for (size_t i = begin; i < end; ++i) {
+                result.setDefects(i, validateShape(Figures<U>::deref(figures[i]), stats));
+            }
+            return stats;
+        },
+        [](ShapeValidationStats a, const ShapeValidationStats &b) {
+            a.add(b);
+            return a;
+        }));
+    return result;
+}
@@ -0,0 +1,588 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FIGURES_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Векторные ядра формулы шнуровки и аффинного преобразования для столбцов
+// double (см. FigureColumns).
+// x[k] / y[k] указывают на k-ю вершину всех n фигур. Набор инструкций выбирается
+// один раз при первом обращении, скалярный вариант доступен на любой платформе.
+// Порядок операций во всех вариантах одинаковый и без FMA, поэтому результаты
+// совпадают со скалярным кодом побитово (сжатие в FMA отключено ниже).
+
+enum class SimdIsa { Scalar, Sse2, Avx2, Avx512 };
+
+template<size_t N>
+struct ShoelaceKernels {
+    // out[i] = удвоенная ориентированная площадь i-й фигуры
+    void (*doubleAreas)(const double *const *x, const double *const *y, size_t n, double *out);
+    // s[i] = 2A, cx[i] = sum (xk + xj) * cross, cy[i] = sum (yk + yj) * cross
+    void (*centroidSums)(const double *const *x, const double *const *y, size_t n,
+                         double *s, double *cx, double *cy);
+};
+
+// Аффинное преобразование на месте одной пары столбцов x / y длины n,
+// m = {a, b, tx, c, d, ty} (см. Affine2)
+using AffineKernel = void (*)(const double *m, double *x, double *y, size_t n);
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+template<size_t N>
+void doubleAreasScalar(const double *const *x, const double *const *y, size_t begin, size_t n, double *out) {
+    for (size_t i = begin; i < n; ++i) {
+        double s = 0;
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            s += x[k][i] * y[j][i] - x[j][i] * y[k][i];
+        }
+        out[i] = s;
+    }
+}
+
+template<size_t N>
+void centroidSumsScalar(const double *const *x, const double *const *y, size_t begin, size_t n,
+                        double *s, double *cx, double *cy) {
+    for (size_t i = begin; i < n; ++i) {
+        double a = 0, sx = 0, sy = 0;
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            const double cross = x[k][i] * y[j][i] - x[j][i] * y[k][i];
+            a += cross;
+            sx += (x[k][i] + x[j][i]) * cross;
+            sy += (y[k][i] + y[j][i]) * cross;
+        }
+        s[i] = a;
+        cx[i] = sx;
+        cy[i] = sy;
+    }
+}
+
+inline void affineScalar(const double *m, double *x, double *y, size_t begin, size_t n) {
+    for (size_t i = begin; i < n; ++i) {
+        const double px = x[i], py = y[i];
+        x[i] = m[0] * px + m[1] * py + m[2];
+        y[i] = m[3] * px + m[4] * py + m[5];
+    }
+}
+
+#ifdef FIGURES_SIMD_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+
+template<size_t N>
+void doubleAreasSse2(const double *const *x, const double *const *y, size_t n, double *out) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d s = _mm_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            __m128d cross = _mm_sub_pd(_mm_mul_pd(_mm_loadu_pd(x[k] + i), _mm_loadu_pd(y[j] + i)),
+                                       _mm_mul_pd(_mm_loadu_pd(x[j] + i), _mm_loadu_pd(y[k] + i)));
+            s = _mm_add_pd(s, cross);
+        }
+        _mm_storeu_pd(out + i, s);
+    }
+    doubleAreasScalar<N>(x, y, i, n, out);
+}
+
+template<size_t N>
+void centroidSumsSse2(const double *const *x, const double *const *y, size_t n,
+                      double *s, double *cx, double *cy) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d a = _mm_setzero_pd(), sx = _mm_setzero_pd(), sy = _mm_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            __m128d xk = _mm_loadu_pd(x[k] + i), yk = _mm_loadu_pd(y[k] + i);
+            __m128d xj = _mm_loadu_pd(x[j] + i), yj = _mm_loadu_pd(y[j] + i);
+            __m128d cross = _mm_sub_pd(_mm_mul_pd(xk, yj), _mm_mul_pd(xj, yk));
+            a = _mm_add_pd(a, cross);
+            sx = _mm_add_pd(sx, _mm_mul_pd(_mm_add_pd(xk, xj), cross));
+            sy = _mm_add_pd(sy, _mm_mul_pd(_mm_add_pd(yk, yj), cross));
+        }
+        _mm_storeu_pd(s + i, a);
+        _mm_storeu_pd(cx + i, sx);
+        _mm_storeu_pd(cy + i, sy);
+    }
+    centroidSumsScalar<N>(x, y, i, n, s, cx, cy);
+}
+
+inline void affineSse2(const double *m, double *x, double *y, size_t n) {
+    const __m128d a = _mm_set1_pd(m[0]), b = _mm_set1_pd(m[1]), tx = _mm_set1_pd(m[2]);
+    const __m128d c = _mm_set1_pd(m[3]), d = _mm_set1_pd(m[4]), ty = _mm_set1_pd(m[5]);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d px = _mm_loadu_pd(x + i), py = _mm_loadu_pd(y + i);
+        _mm_storeu_pd(x + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, px), _mm_mul_pd(b, py)), tx));
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(c, px), _mm_mul_pd(d, py)), ty));
+    }
+    affineScalar(m, x, y, i, n);
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+template<size_t N>
+void doubleAreasAvx2(const double *const *x, const double *const *y, size_t n, double *out) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d s = _mm256_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            __m256d cross = _mm256_sub_pd(_mm256_mul_pd(_mm256_loadu_pd(x[k] + i), _mm256_loadu_pd(y[j] + i)),
+                                          _mm256_mul_pd(_mm256_loadu_pd(x[j] + i), _mm256_loadu_pd(y[k] + i)));
+            s = _mm256_add_pd(s, cross);
+        }
+        _mm256_storeu_pd(out + i, s);
+    }
+    doubleAreasScalar<N>(x, y, i, n, out);
+}
+
+template<size_t N>
+void centroidSumsAvx2(const double *const *x, const double *const *y, size_t n,
+                      double *s, double *cx, double *cy) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d a = _mm256_setzero_pd(), sx = _mm256_setzero_pd(), sy = _mm256_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            __m256d xk = _mm256_loadu_pd(x[k] + i), yk = _mm256_loadu_pd(y[k] + i);
+            __m256d xj = _mm256_loadu_pd(x[j] + i), yj = _mm256_loadu_pd(y[j] + i);
+            __m256d cross = _mm256_sub_pd(_mm256_mul_pd(xk, yj), _mm256_mul_pd(xj, yk));
+            a = _mm256_add_pd(a, cross);
+            sx = _mm256_add_pd(sx, _mm256_mul_pd(_mm256_add_pd(xk, xj), cross));
+            sy = _mm256_add_pd(sy, _mm256_mul_pd(_mm256_add_pd(yk, yj), cross));
+        }
+        _mm256_storeu_pd(s + i, a);
+        _mm256_storeu_pd(cx + i, sx);
+        _mm256_storeu_pd(cy + i, sy);
+    }
+    centroidSumsScalar<N>(x, y, i, n, s, cx, cy);
+}
+
+inline void affineAvx2(const double *m, double *x, double *y, size_t n) {
+    const __m256d a = _mm256_set1_pd(m[0]), b = _mm256_set1_pd(m[1]), tx = _mm256_set1_pd(m[2]);
+    const __m256d c = _mm256_set1_pd(m[3]), d = _mm256_set1_pd(m[4]), ty = _mm256_set1_pd(m[5]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d px = _mm256_loadu_pd(x + i), py = _mm256_loadu_pd(y + i);
+        _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a, px), _mm256_mul_pd(b, py)), tx));
+        _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(c, px), _mm256_mul_pd(d, py)), ty));
+    }
+    affineScalar(m, x, y, i, n);
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+template<size_t N>
+void doubleAreasAvx512(const double *const *x, const double *const *y, size_t n, double *out) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d s = _mm512_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            __m512d cross = _mm512_sub_pd(_mm512_mul_pd(_mm512_loadu_pd(x[k] + i), _mm512_loadu_pd(y[j] + i)),
+                                          _mm512_mul_pd(_mm512_loadu_pd(x[j] + i), _mm512_loadu_pd(y[k] + i)));
+            s = _mm512_add_pd(s, cross);
+        }
+        _mm512_storeu_pd(out + i, s);
+    }
+    doubleAreasScalar<N>(x, y, i, n, out);
+}
+
+template<size_t N>
+void centroidSumsAvx512(const double *const *x, const double *const *y, size_t n,
+                        double *s, double *cx, double *cy) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d a = _mm512_setzero_pd(), sx = _mm512_setzero_pd(), sy = _mm512_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t j = (k + 1 == N) ? 0 : k + 1;
+            __m512d xk = _mm512_loadu_pd(x[k] + i), yk = _mm512_loadu_pd(y[k] + i);
+            __m512d xj = _mm512_loadu_pd(x[j] + i), yj = _mm512_loadu_pd(y[j] + i);
+            __m512d cross = _mm512_sub_pd(_mm512_mul_pd(xk, yj), _mm512_mul_pd(xj, yk));
+            a = _mm512_add_pd(a, cross);
+            sx = _mm512_add_pd(sx, _mm512_mul_pd(_mm512_add_pd(xk, xj), cross));
+            sy = _mm512_add_pd(sy, _mm512_mul_pd(_mm512_add_pd(yk, yj), cross));
+        }
+        _mm512_storeu_pd(s + i, a);
+        _mm512_storeu_pd(cx + i, sx);
+        _mm512_storeu_pd(cy + i, sy);
+    }
+    centroidSumsScalar<N>(x, y, i, n, s, cx, cy);
+}
+
+inline void affineAvx512(const double *m, double *x, double *y, size_t n) {
+    const __m512d a = _mm512_set1_pd(m[0]), b = _mm512_set1_pd(m[1]), tx = _mm512_set1_pd(m[2]);
+    const __m512d c = _mm512_set1_pd(m[3]), d = _mm512_set1_pd(m[4]), ty = _mm512_set1_pd(m[5]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d px = _mm512_loadu_pd(x + i), py = _mm512_loadu_pd(y + i);
+        _mm512_storeu_pd(x + i, _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(a, px), _mm512_mul_pd(b, py)), tx));
+        _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(c, px), _mm512_mul_pd(d, py)), ty));
+    }
+    affineScalar(m, x, y, i, n);
+}
+
+#pragma GCC pop_options
+
+#endif // FIGURES_SIMD_X86
+
+#pragma GCC pop_options
+
+inline bool isSimdIsaSupported(SimdIsa isa) {
+    switch (isa) {
+    case SimdIsa::Scalar:
+        return true;
+#ifdef FIGURES_SIMD_X86
+    case SimdIsa::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case SimdIsa::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case SimdIsa::Avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+// Самый широкий набор инструкций, доступный на этом процессоре
+inline SimdIsa detectSimdIsa() {
+    for (SimdIsa isa : {SimdIsa::Avx512, SimdIsa::Avx2, SimdIsa::Sse2}) {
+        if (isSimdIsaSupported(isa))
+            return isa;
+    }
+    return SimdIsa::Scalar;
+}
+
+inline SimdIsa activeSimdIsa() {
+    static const SimdIsa isa = detectSimdIsa();
+    return isa;
+}
+
+template<size_t N>
+ShoelaceKernels<N> getShoelaceKernels(SimdIsa isa) {
+    switch (isa) {
+#ifdef FIGURES_SIMD_X86
+    case SimdIsa::Sse2:
+        return {doubleAreasSse2<N>, centroidSumsSse2<N>};
+    case SimdIsa::Avx2:
+        return {doubleAreasAvx2<N>, centroidSumsAvx2<N>};
+    case SimdIsa::Avx512:
+        return {doubleAreasAvx512<N>, centroidSumsAvx512<N>};
+#endif
+    default:
+        return {
+            [](const double *const *x, const double *const *y, size_t n, double *out) {
+                doubleAreasScalar<N>(x, y, 0, n, out);
+            },
+            [](const double *const *x, const double *const *y, size_t n, double *s, double *cx, double *cy) {
+                centroidSumsScalar<N>(x, y, 0, n, s, cx, cy);
+            },
+        };
+    }
+}
+
+// Ядра для текущего процессора, выбираются один раз
+template<size_t N>
+const ShoelaceKernels<N> &activeShoelaceKernels() {
+    static const ShoelaceKernels<N> kernels = getShoelaceKernels<N>(activeSimdIsa());
+    return kernels;
+}
+
+inline AffineKernel getAffineKernel(SimdIsa isa) {
+    switch (isa) {
+#ifdef FIGURES_SIMD_X86
+    case SimdIsa::Sse2:
+        return affineSse2;
+    case SimdIsa::Avx2:
+        return affineAvx2;
+    case SimdIsa::Avx512:
+        return affineAvx512;
+#endif
+    default:
+        return [](const double *m, double *x, double *y, size_t n) { affineScalar(m, x, y, 0, n); };
+    }
+}
+
+inline AffineKernel activeAffineKernel() {
+    static const AffineKernel kernel = getAffineKernel(activeSimdIsa());
+    return kernel;
+}
+
+// Ядра для столбцов float, которые считают в float на полной ширине вектора
+// (вдвое больше фигур за инструкцию, чем в double). Чтобы ограничить потерю
+// точности, каждая фигура сдвигается в свою первую вершину (рёбра, выходящие из
+// неё, дают нулевое векторное произведение), а суммы по вершинам ведутся по
+// Ноймайеру. Как и выше, все варианты побитово совпадают со скалярным.
+
+template<size_t N>
+struct FloatShoelaceKernels {
+    // out[i] = удвоенная ориентированная площадь i-й фигуры
+    void (*doubleAreas)(const float *const *x, const float *const *y, size_t n, float *out);
+    // s[i] = 2A, cx[i] / cy[i] - центр масс i-й фигуры
+    void (*centroids)(const float *const *x, const float *const *y, size_t n, float *s, float *cx, float *cy);
+};
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+// Шаг суммы Ноймайера: sum + compensation точнее, чем просто sum
+inline void neumaierAdd(float &sum, float &compensation, float value) {
+    const float t = sum + value;
+    compensation += (std::fabs(sum) >= std::fabs(value)) ? (sum - t) + value : (value - t) + sum;
+    sum = t;
+}
+
+template<size_t N>
+void floatDoubleAreasScalar(const float *const *x, const float *const *y, size_t begin, size_t n, float *out) {
+    for (size_t i = begin; i < n; ++i) {
+        const float ox = x[0][i], oy = y[0][i];
+        float s = 0, c = 0;
+        for (size_t k = 1; k + 1 < N; ++k) {
+            const float xk = x[k][i] - ox, yk = y[k][i] - oy;
+            const float xj = x[k + 1][i] - ox, yj = y[k + 1][i] - oy;
+            neumaierAdd(s, c, xk * yj - xj * yk);
+        }
+        out[i] = s + c;
+    }
+}
+
+template<size_t N>
+void floatCentroidsScalar(const float *const *x, const float *const *y, size_t begin, size_t n,
+                          float *s, float *cx, float *cy) {
+    for (size_t i = begin; i < n; ++i) {
+        const float ox = x[0][i], oy = y[0][i];
+        float a = 0, ac = 0, sx = 0, sxc = 0, sy = 0, syc = 0;
+        for (size_t k = 1; k + 1 < N; ++k) {
+            const float xk = x[k][i] - ox, yk = y[k][i] - oy;
+            const float xj = x[k + 1][i] - ox, yj = y[k + 1][i] - oy;
+            const float cross = xk * yj - xj * yk;
+            neumaierAdd(a, ac, cross);
+            neumaierAdd(sx, sxc, (xk + xj) * cross);
+            neumaierAdd(sy, syc, (yk + yj) * cross);
+        }
+        const float area2 = a + ac;
+        s[i] = area2;
+        cx[i] = ox + (sx + sxc) / (3 * area2);
+        cy[i] = oy + (sy + syc) / (3 * area2);
+    }
+}
+
+#ifdef FIGURES_SIMD_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+
+inline void neumaierAddSse2(__m128 &sum, __m128 &compensation, __m128 value) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 t = _mm_add_ps(sum, value);
+    const __m128 bigSum = _mm_cmpge_ps(_mm_and_ps(sum, absMask), _mm_and_ps(value, absMask));
+    const __m128 lost = _mm_or_ps(_mm_and_ps(bigSum, _mm_add_ps(_mm_sub_ps(sum, t), value)),
+                                  _mm_andnot_ps(bigSum, _mm_add_ps(_mm_sub_ps(value, t), sum)));
+    compensation = _mm_add_ps(compensation, lost);
+    sum = t;
+}
+
+template<size_t N>
+void floatDoubleAreasSse2(const float *const *x, const float *const *y, size_t n, float *out) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 ox = _mm_loadu_ps(x[0] + i), oy = _mm_loadu_ps(y[0] + i);
+        __m128 s = _mm_setzero_ps(), c = _mm_setzero_ps();
+        for (size_t k = 1; k + 1 < N; ++k) {
+            __m128 xk = _mm_sub_ps(_mm_loadu_ps(x[k] + i), ox), yk = _mm_sub_ps(_mm_loadu_ps(y[k] + i), oy);
+            __m128 xj = _mm_sub_ps(_mm_loadu_ps(x[k + 1] + i), ox), yj = _mm_sub_ps(_mm_loadu_ps(y[k + 1] + i), oy);
+            neumaierAddSse2(s, c, _mm_sub_ps(_mm_mul_ps(xk, yj), _mm_mul_ps(xj, yk)));
+        }
+        _mm_storeu_ps(out + i, _mm_add_ps(s, c));
+    }
+    floatDoubleAreasScalar<N>(x, y, i, n, out);
+}
+
+template<size_t N>
+void floatCentroidsSse2(const float *const *x, const float *const *y, size_t n, float *s, float *cx, float *cy) {
+    const __m128 three = _mm_set1_ps(3);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 ox = _mm_loadu_ps(x[0] + i), oy = _mm_loadu_ps(y[0] + i);
+        __m128 a = _mm_setzero_ps(), ac = a, sx = a, sxc = a, sy = a, syc = a;
+        for (size_t k = 1; k + 1 < N; ++k) {
+            __m128 xk = _mm_sub_ps(_mm_loadu_ps(x[k] + i), ox), yk = _mm_sub_ps(_mm_loadu_ps(y[k] + i), oy);
+            __m128 xj = _mm_sub_ps(_mm_loadu_ps(x[k + 1] + i), ox), yj = _mm_sub_ps(_mm_loadu_ps(y[k + 1] + i), oy);
+            __m128 cross = _mm_sub_ps(_mm_mul_ps(xk, yj), _mm_mul_ps(xj, yk));
+            neumaierAddSse2(a, ac, cross);
+            neumaierAddSse2(sx, sxc, _mm_mul_ps(_mm_add_ps(xk, xj), cross));
+            neumaierAddSse2(sy, syc, _mm_mul_ps(_mm_add_ps(yk, yj), cross));
+        }
+        const __m128 area2 = _mm_add_ps(a, ac), denom = _mm_mul_ps(three, area2);
+        _mm_storeu_ps(s + i, area2);
+        _mm_storeu_ps(cx + i, _mm_add_ps(ox, _mm_div_ps(_mm_add_ps(sx, sxc), denom)));
+        _mm_storeu_ps(cy + i, _mm_add_ps(oy, _mm_div_ps(_mm_add_ps(sy, syc), denom)));
+    }
+    floatCentroidsScalar<N>(x, y, i, n, s, cx, cy);
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+inline void neumaierAddAvx2(__m256 &sum, __m256 &compensation, __m256 value) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 t = _mm256_add_ps(sum, value);
+    const __m256 bigSum = _mm256_cmp_ps(_mm256_and_ps(sum, absMask), _mm256_and_ps(value, absMask), _CMP_GE_OQ);
+    const __m256 lost = _mm256_blendv_ps(_mm256_add_ps(_mm256_sub_ps(value, t), sum),
+                                         _mm256_add_ps(_mm256_sub_ps(sum, t), value), bigSum);
+    compensation = _mm256_add_ps(compensation, lost);
+    sum = t;
+}
+
+template<size_t N>
+void floatDoubleAreasAvx2(const float *const *x, const float *const *y, size_t n, float *out) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 ox = _mm256_loadu_ps(x[0] + i), oy = _mm256_loadu_ps(y[0] + i);
+        __m256 s = _mm256_setzero_ps(), c = _mm256_setzero_ps();
+        for (size_t k = 1; k + 1 < N; ++k) {
+            __m256 xk = _mm256_sub_ps(_mm256_loadu_ps(x[k] + i), ox);
+            __m256 yk = _mm256_sub_ps(_mm256_loadu_ps(y[k] + i), oy);
+            __m256 xj = _mm256_sub_ps(_mm256_loadu_ps(x[k + 1] + i), ox);
+            __m256 yj = _mm256_sub_ps(_mm256_loadu_ps(y[k + 1] + i), oy);
+            neumaierAddAvx2(s, c, _mm256_sub_ps(_mm256_mul_ps(xk, yj), _mm256_mul_ps(xj, yk)));
+        }
+        _mm256_storeu_ps(out + i, _mm256_add_ps(s, c));
+    }
+    floatDoubleAreasScalar<N>(x, y, i, n, out);
+}
+
+template<size_t N>
+void floatCentroidsAvx2(const float *const *x, const float *const *y, size_t n, float *s, float *cx, float *cy) {
+    const __m256 three = _mm256_set1_ps(3);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 ox = _mm256_loadu_ps(x[0] + i), oy = _mm256_loadu_ps(y[0] + i);
+        __m256 a = _mm256_setzero_ps(), ac = a, sx = a, sxc = a, sy = a, syc = a;
+        for (size_t k = 1; k + 1 < N; ++k) {
+            __m256 xk = _mm256_sub_ps(_mm256_loadu_ps(x[k] + i), ox);
+            __m256 yk = _mm256_sub_ps(_mm256_loadu_ps(y[k] + i), oy);
+            __m256 xj = _mm256_sub_ps(_mm256_loadu_ps(x[k + 1] + i), ox);
+            __m256 yj = _mm256_sub_ps(_mm256_loadu_ps(y[k + 1] + i), oy);
+            __m256 cross = _mm256_sub_ps(_mm256_mul_ps(xk, yj), _mm256_mul_ps(xj, yk));
+            neumaierAddAvx2(a, ac, cross);
+            neumaierAddAvx2(sx, sxc, _mm256_mul_ps(_mm256_add_ps(xk, xj), cross));
+            neumaierAddAvx2(sy, syc, _mm256_mul_ps(_mm256_add_ps(yk, yj), cross));
+        }
+        const __m256 area2 = _mm256_add_ps(a, ac), denom = _mm256_mul_ps(three, area2);
+        _mm256_storeu_ps(s + i, area2);
+        _mm256_storeu_ps(cx + i, _mm256_add_ps(ox, _mm256_div_ps(_mm256_add_ps(sx, sxc), denom)));
+        _mm256_storeu_ps(cy + i, _mm256_add_ps(oy, _mm256_div_ps(_mm256_add_ps(sy, syc), denom)));
+    }
+    floatCentroidsScalar<N>(x, y, i, n, s, cx, cy);
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+inline void neumaierAddAvx512(__m512 &sum, __m512 &compensation, __m512 value) {
+    const __m512 t = _mm512_add_ps(sum, value);
+    const __mmask16 bigSum = _mm512_cmp_ps_mask(_mm512_abs_ps(sum), _mm512_abs_ps(value), _CMP_GE_OQ);
+    const __m512 lost = _mm512_mask_blend_ps(bigSum, _mm512_add_ps(_mm512_sub_ps(value, t), sum),
+                                             _mm512_add_ps(_mm512_sub_ps(sum, t), value));
+    compensation = _mm512_add_ps(compensation, lost);
+    sum = t;
+}
+
+template<size_t N>
+void floatDoubleAreasAvx512(const float *const *x, const float *const *y, size_t n, float *out) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512 ox = _mm512_loadu_ps(x[0] + i), oy = _mm512_loadu_ps(y[0] + i);
+        __m512 s = _mm512_setzero_ps(), c = _mm512_setzero_ps();
+        for (size_t k = 1; k + 1 < N; ++k) {
+            __m512 xk = _mm512_sub_ps(_mm512_loadu_ps(x[k] + i), ox);
+            __m512 yk = _mm512_sub_ps(_mm512_loadu_ps(y[k] + i), oy);
+            __m512 xj = _mm512_sub_ps(_mm512_loadu_ps(x[k + 1] + i), ox);
+            __m512 yj = _mm512_sub_ps(_mm512_loadu_ps(y[k + 1] + i), oy);
+            neumaierAddAvx512(s, c, _mm512_sub_ps(_mm512_mul_ps(xk, yj), _mm512_mul_ps(xj, yk)));
+        }
+        _mm512_storeu_ps(out + i, _mm512_add_ps(s, c));
+    }
+    floatDoubleAreasScalar<N>(x, y, i, n, out);
+}
+
+template<size_t N>
+void floatCentroidsAvx512(const float *const *x, const float *const *y, size_t n, float *s, float *cx, float *cy) {
+    const __m512 three = _mm512_set1_ps(3);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512 ox = _mm512_loadu_ps(x[0] + i), oy = _mm512_loadu_ps(y[0] + i);
+        __m512 a = _mm512_setzero_ps(), ac = a, sx = a, sxc = a, sy = a, syc = a;
+        for (size_t k = 1; k + 1 < N; ++k) {
+            __m512 xk = _mm512_sub_ps(_mm512_loadu_ps(x[k] + i), ox);
+            __m512 yk = _mm512_sub_ps(_mm512_loadu_ps(y[k] + i), oy);
+            __m512 xj = _mm512_sub_ps(_mm512_loadu_ps(x[k + 1] + i), ox);
+            __m512 yj = _mm512_sub_ps(_mm512_loadu_ps(y[k + 1] + i), oy);
+            __m512 cross = _mm512_sub_ps(_mm512_mul_ps(xk, yj), _mm512_mul_ps(xj, yk));
+            neumaierAddAvx512(a, ac, cross);
+            neumaierAddAvx512(sx, sxc, _mm512_mul_ps(_mm512_add_ps(xk, xj), cross));
+            neumaierAddAvx512(sy, syc, _mm512_mul_ps(_mm512_add_ps(yk, yj), cross));
+        }
+        const __m512 area2 = _mm512_add_ps(a, ac), denom = _mm512_mul_ps(three, area2);
+        _mm512_storeu_ps(s + i, area2);
+        _mm512_storeu_ps(cx + i, _mm512_add_ps(ox, _mm512_div_ps(_mm512_add_ps(sx, sxc), denom)));
+        _mm512_storeu_ps(cy + i, _mm512_add_ps(oy, _mm512_div_ps(_mm512_add_ps(sy, syc), denom)));
+    }
+    floatCentroidsScalar<N>(x, y, i, n, s, cx, cy);
+}
+
+#pragma GCC pop_options
+
+#endif // FIGURES_SIMD_X86
+
+#pragma GCC pop_options
+
+template<size_t N>
+FloatShoelaceKernels<N> getFloatShoelaceKernels(SimdIsa isa) {
+    switch (isa) {
+#ifdef FIGURES_SIMD_X86
+    case SimdIsa::Sse2:
+        return {floatDoubleAreasSse2<N>, floatCentroidsSse2<N>};
+    case SimdIsa::Avx2:
+        return {floatDoubleAreasAvx2<N>, floatCentroidsAvx2<N>};
+    case SimdIsa::Avx512:
+        return {floatDoubleAreasAvx512<N>, floatCentroidsAvx512<N>};
+#endif
+    default:
+        return {
+            [](const float *const *x, const float *const *y, size_t n, float *out) {
+                floatDoubleAreasScalar<N>(x, y, 0, n, out);
+            },
+            [](const float *const *x, const float *const *y, size_t n, float *s, float *cx, float *cy) {
+                floatCentroidsScalar<N>(x, y, 0, n, s, cx, cy);
+            },
+        };
+    }
+}
+
+// Ядра для текущего процессора, выбираются один раз
+template<size_t N>
+const FloatShoelaceKernels<N> &activeFloatShoelaceKernels() {
+    static const FloatShoelaceKernels<N> kernels = getFloatShoelaceKernels<N>(activeSimdIsa());
+    return kernels;
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "bounding_box.h"
+#include "figures.h"
+#include "point.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Равномерная сетка над ограничивающими прямоугольниками фигур. Элемент
+// регистрируется во всех ячейках, которые задевает его прямоугольник; запросы
+// смотрят только ячейки окна. Чтобы не выдавать элемент дважды, он сообщается
+// только из той ячейки, где лежит левый нижний угол пересечения окна и
+// прямоугольника, поэтому запросы ничего не пишут и безопасны из нескольких потоков.
+// Номера ячеек ограничены [-maxCell, maxCell], так что дальние и бесконечные
+// координаты попадают в крайние ячейки. Прямоугольник больше maxEntryCells ячеек
+// в сетку не раскладывается и проверяется каждым запросом отдельно; окно, которое
+// накрывает больше ячеек, чем занято, перебирает занятые ячейки, а не окно.
+template<Scalar T>
+class SpatialGrid {
+  public:
+    explicit SpatialGrid(double cellSize = 1.0) : cellSize(cellSize) {}
+
+    void insert(FigureHandle handle, const BoundingBox<T> &box) {
+        if (handle.slot >= entries.size())
+            entries.resize(handle.slot + 1);
+        Entry &entry = entries[handle.slot];
+        if (entry.present) {
+            removeEntry(handle.slot);
+            count--;
+        }
+        entry = Entry{handle, box, true, cellCount(box) > maxEntryCells};
+        if (entry.oversized)
+            oversized.push_back(handle.slot);
+        else
+            forEachCell(box, [&](uint64_t key) { cells[key].push_back(handle.slot); });
+        count++;
+    }
+
+    bool remove(FigureHandle handle) {
+        if (!contains(handle))
+            return false;
+        removeEntry(handle.slot);
+        entries[handle.slot].present = false;
+        count--;
+        return true;
+    }
+
+    bool contains(FigureHandle handle) const {
+        return handle.slot < entries.size() && entries[handle.slot].present && entries[handle.slot].handle == handle;
+    }
+
+    // Все элементы, чей прямоугольник пересекает window (границы включаются)
+    void queryWindow(const BoundingBox<T> &window, std::vector<FigureHandle> &out) const {
+        auto visit = [&](uint64_t key, const std::vector<uint32_t> &slots) {
+            for (uint32_t slot : slots) {
+                const Entry &entry = entries[slot];
+                if (!entry.box.intersects(window))
+                    continue;
+                T cornerX = std::max(window.minX, entry.box.minX);
+                T cornerY = std::max(window.minY, entry.box.minY);
+                if (cellKey(cellIndex(cornerX), cellIndex(cornerY)) == key)
+                    out.push_back(entry.handle);
+            }
+        };
+        if (cellCount(window) > cells.size()) {
+            const int32_t x0 = cellIndex(window.minX), x1 = cellIndex(window.maxX);
+            const int32_t y0 = cellIndex(window.minY), y1 = cellIndex(window.maxY);
+            for (const auto &[key, slots] : cells) {
+                const int32_t cx = static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+                const int32_t cy = static_cast<int32_t>(static_cast<uint32_t>(key));
+                if (x0 <= cx && cx <= x1 && y0 <= cy && cy <= y1)
+                    visit(key, slots);
+            }
+        } else {
+            forEachCell(window, [&](uint64_t key) {
+                auto it = cells.find(key);
+                if (it != cells.end())
+                    visit(key, it->second);
+            });
+        }
+        for (uint32_t slot : oversized) {
+            if (entries[slot].box.intersects(window))
+                out.push_back(entries[slot].handle);
+        }
+    }
+
+    // Все элементы, чей прямоугольник содержит p
+    void queryPoint(const Point<T> &p, std::vector<FigureHandle> &out) const {
+        auto it = cells.find(cellKey(cellIndex(p[0]), cellIndex(p[1])));
+        if (it != cells.end()) {
+            for (uint32_t slot : it->second) {
+                if (entries[slot].box.contains(p))
+                    out.push_back(entries[slot].handle);
+            }
+        }
+        for (uint32_t slot : oversized) {
+            if (entries[slot].box.contains(p))
+                out.push_back(entries[slot].handle);
+        }
+    }
+
+    void clear() {
+        cells.clear();
+        entries.clear();
+        oversized.clear();
+        count = 0;
+    }
+
+    size_t getSize() const { return count; }
+    double getCellSize() const { return cellSize; }
+
+    // Размер ячейки порядка среднего размера прямоугольника
+    template<class U>
+    static double suggestCellSize(const Figures<U> &figures) {
+        double sum = 0;
+        for (const auto &item : figures) {
+            auto box = Figures<U>::deref(item).calcBoundingBox();
+            sum += std::max<double>(box.maxX - box.minX, box.maxY - box.minY);
+        }
+        return figures.getSize() == 0 || sum <= 0 ? 1.0 : 2 * sum / figures.getSize();
+    }
+
+    // Пакетное построение по всем фигурам коллекции
+    template<class U>
+    void build(const Figures<U> &figures) {
+        clear();
+        cells.reserve(figures.getSize());
+        for (size_t i = 0; i < figures.getSize(); i++) {
+            insert(figures.handleAt(i), Figures<U>::deref(figures[i]).calcBoundingBox());
+        }
+    }
+
+    static constexpr int32_t maxCell = 1 << 30;
+    static constexpr uint64_t maxEntryCells = 1024;
+
+  private:
+    struct Entry {
+        FigureHandle handle;
+        BoundingBox<T> box;
+        bool present = false;
+        bool oversized = false;   // лежит в oversized, а не в ячейках
+    };
+
+    // NaN попадает в ячейку -maxCell
+    int32_t cellIndex(T value) const {
+        const double scaled = std::floor(static_cast<double>(value) / cellSize);
+        if (!(scaled > -maxCell))
+            return -maxCell;
+        return scaled < maxCell ? static_cast<int32_t>(scaled) : maxCell;
+    }
+
+    uint64_t cellCount(const BoundingBox<T> &box) const {
+        const int64_t width = int64_t{cellIndex(box.maxX)} - cellIndex(box.minX) + 1;
+        const int64_t height = int64_t{cellIndex(box.maxY)} - cellIndex(box.minY) + 1;
+        return width <= 0 || height <= 0 ? 0 : static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+    }
+
+    static uint64_t cellKey(int32_t cx, int32_t cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    template<class F>
+    void forEachCell(const BoundingBox<T> &box, F &&f) const {
+        const int32_t x0 = cellIndex(box.minX), x1 = cellIndex(box.maxX);
+        const int32_t y0 = cellIndex(box.minY), y1 = cellIndex(box.maxY);
+        for (int32_t cx = x0; cx <= x1; ++cx) {
+            for (int32_t cy = y0; cy <= y1; ++cy) {
+                f(cellKey(cx, cy));
+            }
+        }
+    }
+
+    void removeEntry(uint32_t slot) {
+        const Entry &entry = entries[slot];
+        if (entry.oversized) {
+            auto pos = std::find(oversized.begin(), oversized.end(), slot);
+            *pos = oversized.back();
+            oversized.pop_back();
+            return;
+        }
+        forEachCell(entry.box, [&](uint64_t key) {
+            auto it = cells.find(key);
+            if (it == cells.end())
+                return;
+            auto &slots = it->second;
+            auto pos = std::find(slots.begin(), slots.end(), slot);
+            if (pos != slots.end()) {
+                *pos = slots.back();
+                slots.pop_back();
+            }
+            if (slots.empty())
+                cells.erase(it);
+        });
+    }
+
+    double cellSize;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<Entry> entries;   // по номеру слота FigureHandle
+    std::vector<uint32_t> oversized;
+    size_t count = 0;
+};
+
+// Figures вместе с сеткой, которая обновляется при каждом добавлении и удалении
+template<class U>
+class IndexedFigures {
+  public:
+    using Coord = typename std::remove_cvref_t<decltype(Figures<U>::deref(std::declval<U &>()))>::value_type;
+
+    explicit IndexedFigures(double cellSize = 1.0) : grid(cellSize) {}
+
+    FigureHandle addFigure(U fig) {
+        FigureHandle handle = figures.insertFigure(std::move(fig));
+        grid.insert(handle, Figures<U>::deref(*std::as_const(figures).get(handle)).calcBoundingBox());
+        return handle;
+    }
+
+    void deleteFigure(int index) {
+        if (index < 0 || static_cast<size_t>(index) >= figures.getSize())
+            return;
+        grid.remove(figures.handleAt(index));
+        figures.deleteFigure(index);
+    }
+
+    bool eraseFigure(FigureHandle handle) {
+        grid.remove(handle);
+        return figures.eraseFigure(handle);
+    }
+
+    // Нужно вызвать после изменения вершин фигуры через get/operator[]
+    void refresh(FigureHandle handle) {
+        if (const U *fig = std::as_const(figures).get(handle))
+            grid.insert(handle, Figures<U>::deref(*fig).calcBoundingBox());
+    }
+
+    std::vector<FigureHandle> queryWindow(const BoundingBox<Coord> &window) const {
+        std::vector<FigureHandle> out;
+        grid.queryWindow(window, out);
+        return out;
+    }
+
+    std::vector<FigureHandle> queryPoint(const Point<Coord> &p) const {
+        std::vector<FigureHandle> out;
+        grid.queryPoint(p, out);
+        return out;
+    }
+
+    Figures<U> &getFigures() { return figures; }
+    const Figures<U> &getFigures() const { return figures; }
+    const SpatialGrid<Coord> &getGrid() const { return grid; }
+
+  private:
+    Figures<U> figures;
+    SpatialGrid<Coord> grid;
+};
@@ -3,21 +3,28 @@
 #include "figure.h"
 #include "point.h"
 #include <initializer_list>
+#include <utility>
 
 template<Scalar T>
 class Trapezoid : public Figure<T> {
   public:
-    Trapezoid() : Figure<T>(numOfPoints) {}
-    Trapezoid(const std::initializer_list<Point<T>> &t) : Figure<T>(t) {}
-    Trapezoid(const Trapezoid &other) : Figure<T>(other) {}
-    Trapezoid(Trapezoid &&other) : Figure<T>(other) {}
-    Trapezoid &operator=(const Trapezoid &other) {
+    Trapezoid() : Figure<T>(vertices, numOfPoints) {}
+    Trapezoid(const std::initializer_list<Point<T>> &t) : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::assignPoints(t);
+    }
+    Trapezoid(const Trapezoid &other) noexcept : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::operator=(other);
+    }
+    Trapezoid(Trapezoid &&other) noexcept : Figure<T>(vertices, numOfPoints) {
+        Figure<T>::operator=(std::move(other));
+    }
+    Trapezoid &operator=(const Trapezoid &other) noexcept {
         Figure<T>::operator=(other);
         return *this;
     }
 
-    Trapezoid &operator=(Trapezoid &&other) {
-        Figure<T>::operator=(other);
+    Trapezoid &operator=(Trapezoid &&other) noexcept {
+        Figure<T>::operator=(std::move(other));
         return *this;
     }
 
@@ -26,6 +33,11 @@ class Trapezoid : public Figure<T> {
     }
 
     static constexpr int numOfPoints = 4;
+    static constexpr FigureKind figureKind = FigureKind::Trapezoid;
 
     int getNumOfPoints() const override { return numOfPoints; }
+    FigureKind getKind() const override { return figureKind; }
+
+  private:
+    Point<T> vertices[numOfPoints];
 };
\ No newline at end of file
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "figure_report.h"
+#include "figures.h"
+#include "parallel_reduce.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Массив фигур с дешёвыми версиями. Элементы лежат кусками до ChunkSize штук,
+// список кусков (каталог) и сами куски разделяются между версиями через
+// shared_ptr. snapshot() (как и копирование) стоит O(1); изменение копирует
+// каталог, если он общий (O(n / ChunkSize) указателей), и только те куски,
+// которых касается: addFigure и setFigure - один, deleteFigure - один,
+// deleteFigureUnordered - два. Удаление сжимает кусок, а не сдвигает хвост,
+// поэтому куски бывают неполными; опустевший кусок убирается из каталога.
+// Для T = shared_ptr версии разделяют сами фигуры: менять фигуру в одной
+// версии нужно заменой указателя через setFigure. Как и Figures, без
+// синхронизации: версию меняет один поток. Версии делят одни и те же объекты
+// фигур, а их кэш пишется при первом чтении, поэтому addFigure и setFigure
+// прогревают кэш (Figure::warmCache), как ConcurrentFigures: после этого
+// неизменяемые версии можно читать из любых потоков.
+template<class T, size_t ChunkSize = 4096>
+class VersionedFigures {
+  public:
+    static_assert(ChunkSize > 0);
+
+    VersionedFigures() : directory(std::make_shared<Directory>()) {}
+
+    explicit VersionedFigures(const Figures<T> &figures) : VersionedFigures() {
+        for (const auto &fig : figures) {
+            addFigure(fig);
+        }
+    }
+
+    // Копия - тот же снимок. Перемещение тоже копирует (O(1)), чтобы у источника
+    // оставался каталог
+    VersionedFigures(const VersionedFigures &other) = default;
+    VersionedFigures &operator=(const VersionedFigures &other) = default;
+
+    // Текущая версия, которую дальнейшие изменения этого объекта не затронут
+    VersionedFigures snapshot() const { return *this; }
+
+    size_t getSize() const { return directory->size; }
+    size_t getChunkCount() const { return directory->chunks.size(); }
+
+    // Число кусков, общих с other: память, которую версии не дублируют
+    size_t countSharedChunks(const VersionedFigures &other) const {
+        std::unordered_set<const Chunk *> otherChunks;
+        for (const auto &chunk : other.directory->chunks) {
+            otherChunks.insert(chunk.get());
+        }
+        return std::count_if(directory->chunks.begin(), directory->chunks.end(),
+                             [&](const auto &chunk) { return otherChunks.contains(chunk.get()); });
+    }
+
+    const T &operator[](size_t index) const {
+        auto [chunk, offset] = locate(index);
+        return (*directory->chunks[chunk])[offset];
+    }
+
+    void addFigure(T fig) {
+        Figures<T>::deref(fig).warmCache();
+        Directory &dir = ownDirectory();
+        if (dir.chunks.empty() || dir.chunks.back()->size() >= ChunkSize) {
+            dir.offsets.push_back(dir.size);
+            dir.chunks.push_back(std::make_shared<Chunk>());
+            dir.chunks.back()->reserve(ChunkSize);
+        }
+        ownChunk(dir, dir.chunks.size() - 1).push_back(std::move(fig));
+        dir.size++;
+    }
+
+    void setFigure(size_t index, T fig) {
+        if (index >= getSize())
+            return;
+        Figures<T>::deref(fig).warmCache();
+        auto [chunk, offset] = locate(index);
+        Directory &dir = ownDirectory();
+        ownChunk(dir, chunk)[offset] = std::move(fig);
+    }
+
+    // Порядок остальных сохраняется
+    void deleteFigure(size_t index) {
+        if (index >= getSize())
+            return;
+        auto [chunk, offset] = locate(index);
+        Directory &dir = ownDirectory();
+        Chunk &items = ownChunk(dir, chunk);
+        items.erase(items.begin() + offset);
+        for (size_t k = chunk + 1; k < dir.offsets.size(); ++k) {
+            dir.offsets[k]--;
+        }
+        dir.size--;
+        if (items.empty()) {
+            dir.chunks.erase(dir.chunks.begin() + chunk);
+            dir.offsets.erase(dir.offsets.begin() + chunk);
+        }
+    }
+
+    // На место удалённого встаёт последний элемент
+    void deleteFigureUnordered(size_t index) {
+        if (index >= getSize())
+            return;
+        const size_t last = getSize() - 1;
+        if (index != last)
+            setFigure(index, (*this)[last]);
+        deleteFigure(last);
+    }
+
+    // Вызывает f(index, элемент) для позиций [begin, end) подряд
+    template<class F>
+    void forEach(size_t begin, size_t end, F &&f) const {
+        if (begin >= end)
+            return;
+        auto [chunk, offset] = locate(begin);
+        for (size_t index = begin; index < end; ++index, ++offset) {
+            if (offset == directory->chunks[chunk]->size()) {
+                ++chunk;
+                offset = 0;
+            }
+            f(index, (*directory->chunks[chunk])[offset]);
+        }
+    }
+
+    // Результат не зависит от options.threads (см. Figures::calcTotalArea)
+    double calcTotalArea(const ReduceOptions &options = {}) const {
+        CompensatedSum total = parallelReduce(getSize(), options, CompensatedSum{},
+            [this](size_t begin, size_t end) {
+                CompensatedSum s;
+                forEach(begin, end, [&](size_t, const T &fig) { s.add(Figures<T>::deref(fig).calcArea()); });
+                return s;
+            },
+            [](CompensatedSum a, const CompensatedSum &b) {
+                a.add(b);
+                return a;
+            });
+        return total.result();
+    }
+
+    void writeReport(ReportWriter &writer) const {
+        forEach(0, getSize(), [&](size_t index, const T &fig) { writer.writeFigure(index, Figures<T>::deref(fig)); });
+    }
+
+    void printCenterForEachFigure() const { printReport(ReportCenter); }
+    void printAreaForEachFigure() const { printReport(ReportArea); }
+    void printCenterAndAreaForEachFigure() const { printReport(ReportCenterAndArea); }
+
+  private:
+    using Chunk = std::vector<T>;
+
+    struct Directory {
+        std::vector<std::shared_ptr<Chunk>> chunks;
+        std::vector<size_t> offsets;    // offsets[k] - позиция первого элемента chunks[k]
+        size_t size = 0;
+    };
+
+    struct Location {
+        size_t chunk;
+        size_t offset;
+    };
+
+    Location locate(size_t index) const {
+        const auto &offsets = directory->offsets;
+        size_t chunk = std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin() - 1;
+        return {chunk, index - offsets[chunk]};
+    }
+
+    // Каталог и кусок, которые видит только эта версия; общие копируются
+    Directory &ownDirectory() {
+        if (directory.use_count() != 1)
+            directory = std::make_shared<Directory>(*directory);
+        return *directory;
+    }
+
+    static Chunk &ownChunk(Directory &dir, size_t chunk) {
+        auto &items = dir.chunks[chunk];
+        if (items.use_count() != 1) {
+            auto copy = std::make_shared<Chunk>();
+            copy->reserve(chunk + 1 == dir.chunks.size() ? ChunkSize : items->size());
+            copy->assign(items->begin(), items->end());
+            items = std::move(copy);
+        }
+        return *items;
+    }
+
+    void printReport(unsigned fields) const {
+        std::string buffer;
+        ReportWriter writer(std::cout, ReportFormat::Text, buffer, fields);
+        writeReport(writer);
+    }
+
+    std::shared_ptr<Directory> directory;
+};
@@ -0,0 +1,26 @@
+#include "alloc_tracker.h"
+
+#include "../common/alloc_hooks.h"
+
+namespace {
+thread_local AllocScope *currentScope = nullptr;
+} // namespace
+
+AllocScope::AllocScope() : parent(currentScope) {
+    currentScope = this;
+    if (parent == nullptr)
+        setThreadAllocationHook(&AllocScope::record);
+}
+
+AllocScope::~AllocScope() {
+    currentScope = parent;
+    if (parent == nullptr)
+        setThreadAllocationHook(nullptr);
+}
+
+void AllocScope::record(size_t size) {
+    for (AllocScope *scope = currentScope; scope != nullptr; scope = scope->parent) {
+        scope->count++;
+        scope->bytes += size;
+    }
+}
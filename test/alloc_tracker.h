@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+// Счётчик выделений памяти для тестов поверх common/alloc_hooks.h: пока в потоке
+// открыта область AllocScope, каждое выделение засчитывается всем открытым в нём
+// областям (они могут быть вложены друг в друга).
+class AllocScope {
+  public:
+    AllocScope();
+    ~AllocScope();
+
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+
+    size_t getCount() const { return count; }
+    size_t getBytes() const { return bytes; }
+
+    // Обработчик выделений потока (AllocationHook)
+    static void record(size_t size);
+
+  private:
+    AllocScope *parent;
+    size_t count = 0;
+    size_t bytes = 0;
+};
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
+#include <iomanip>
 #include <sstream>
 #include <memory>
 #include <cmath>
+#include <random>
+#include <thread>
 
 #include "../include/point.h"
 #include "../include/figure.h"
@@ -9,6 +12,20 @@
 #include "../include/pentagon.h"
 #include "../include/trapezoid.h"
 #include "../include/figures.h"
+#include "../include/figure_batch.h"
+#include "../include/simd_kernels.h"
+#include "../include/figure_arena.h"
+#include "../include/figure_variant.h"
+#include "../include/figure_file.h"
+#include "../include/figure_text.h"
+#include "../include/spatial_index.h"
+#include "../include/containment.h"
+#include "../include/overlap.h"
+#include "../include/fixed_shape.h"
+#include "../include/concurrent_figures.h"
+#include "../include/versioned_figures.h"
+#include "../include/shape_validation.h"
+#include "alloc_tracker.h"
 
 template <typename T>
 static ::testing::AssertionResult PointsNear(const Point<T>& a, const Point<T>& b, double eps = 1e-9) {
@@ -293,4 +310,1922 @@ TEST(CentroidTest, DiamondAtOriginHasZeroCentroid) {
     Diamond<double> d{ { {0,2}, {2,0}, {0,-2}, {-2,0} } };
     auto c = d.calcGeometricCenter();
     EXPECT_TRUE(PNear<double>(c, Point<double>(0.0, 0.0)));
-}
\ No newline at end of file
+}
+
+// --- Хранение вершин внутри объекта ---
+
+TEST(InlineStorageTest, VerticesLiveInsideObject) {
+    Pentagon<double> p{ { {0,0}, {2,0}, {3,1}, {1.5,3}, {-0.5,1} } };
+    auto pts = p.getPoints();
+    ASSERT_EQ(pts.size(), static_cast<size_t>(Pentagon<double>::numOfPoints));
+
+    auto begin = reinterpret_cast<const char*>(&p);
+    auto first = reinterpret_cast<const char*>(pts.data());
+    EXPECT_GE(first, begin);
+    EXPECT_LE(first + pts.size_bytes(), begin + sizeof(p));
+}
+
+TEST(InlineStorageTest, CopyOwnsItsVertices) {
+    Trapezoid<double> a{ { {0,0}, {4,0}, {3,2}, {1,2} } };
+    Trapezoid<double> b = a;
+    EXPECT_NE(a.getPoints().data(), b.getPoints().data());
+    EXPECT_TRUE(a == b);
+
+    std::istringstream is("0 0  6 0  4 2  2 2");
+    is >> b;
+    EXPECT_FALSE(a == b);
+    EXPECT_NEAR(a.calcArea(), 6.0, 1e-9);
+    EXPECT_NEAR(b.calcArea(), 8.0, 1e-9);
+}
+
+TEST(InlineStorageTest, RejectsWrongVertexCount) {
+    using P = Point<double>;
+    EXPECT_THROW((Trapezoid<double>{P(0, 0), P(4, 0), P(3, 2)}), std::invalid_argument);
+    EXPECT_THROW((Diamond<double>{P(0, 1), P(1, 0), P(0, -1), P(-1, 0), P(5, 5)}), std::invalid_argument);
+    EXPECT_THROW((Pentagon<double>{P(0, 0), P(2, 0), P(3, 1), P(1.5, 3)}), std::invalid_argument);
+    EXPECT_NO_THROW((Pentagon<double>{P(0, 0), P(2, 0), P(3, 1), P(1.5, 3), P(-0.5, 1)}));
+}
+
+
+// --- Столбцовый пакет FigureBatch ---
+
+static Figures<std::shared_ptr<Figure<double>>> makeMixedFigures(size_t n) {
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    for (size_t i = 0; i < n; ++i) {
+        double d = static_cast<double>(i);
+        switch (i % 3) {
+        case 0:
+            figures.addFigure(std::make_shared<Trapezoid<double>>(std::initializer_list<Point<double>>{
+                {d, 0}, {d + 4, 0}, {d + 3, 2 + d / 7}, {d + 1, 2 + d / 7}}));
+            break;
+        case 1:
+            figures.addFigure(std::make_shared<Diamond<double>>(std::initializer_list<Point<double>>{
+                {0, d + 1}, {d + 1, 0}, {0, -d - 1}, {-d - 1, 0}}));
+            break;
+        default:
+            figures.addFigure(std::make_shared<Pentagon<double>>(std::initializer_list<Point<double>>{
+                {d, 0}, {d + 2, 0}, {d + 3, 1}, {d + 1.5, 3}, {d - 0.5, 1}}));
+        }
+    }
+    return figures;
+}
+
+TEST(FigureBatchTest, MatchesFigureAreaAndCenter) {
+    auto figures = makeMixedFigures(37);
+    FigureBatch<double> batch(figures);
+    ASSERT_EQ(batch.getSize(), figures.getSize());
+    EXPECT_EQ(batch.getQuads().getSize() + batch.getPentagons().getSize(), figures.getSize());
+
+    auto areas = batch.areas();
+    auto centers = batch.centroids();
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        EXPECT_NEAR(areas[i], figures[i]->calcArea(), 1e-9);
+        EXPECT_TRUE(PointsNear(centers[i], figures[i]->calcGeometricCenter()));
+    }
+    EXPECT_NEAR(batch.totalArea(), figures.calcTotalArea(), 1e-9);
+}
+
+TEST(FigureBatchTest, BuildsFromValueFigures) {
+    Figures<Pentagon<double>> arr(2);
+    arr.addFigure(Pentagon<double>{ { {0,0}, {2,0}, {3,1}, {1.5,3}, {-0.5,1} } });
+    arr.addFigure(Pentagon<double>{ { {0,0}, {4,0}, {5,1}, {2.5,4}, {-1,1} } });
+
+    FigureBatch<double> batch(arr);
+    EXPECT_EQ(batch.getPentagons().getSize(), static_cast<size_t>(2));
+    EXPECT_EQ(batch.getQuads().getSize(), static_cast<size_t>(0));
+    EXPECT_NEAR(batch.areas()[0], 6.25, 1e-9);
+    EXPECT_NEAR(batch.totalArea(), arr.calcTotalArea(), 1e-9);
+}
+
+// Треугольник только для проверки: в библиотеке фигур с тремя вершинами нет
+class TestTriangle : public Figure<double> {
+  public:
+    TestTriangle() : Figure<double>(storage.data(), storage.size()) {}
+    int getNumOfPoints() const override { return 3; }
+    FigureKind getKind() const override { return FigureKind::Trapezoid; }
+
+  private:
+    std::array<Point<double>, 3> storage{};
+};
+
+TEST(FigureBatchTest, RejectsUnsupportedVertexCount) {
+    FigureBatch<double> batch;
+    batch.addFigure(Diamond<double>{ { {0, 1}, {1, 0}, {0, -1}, {-1, 0} } });
+    EXPECT_THROW(batch.addFigure(TestTriangle()), std::invalid_argument);
+    EXPECT_EQ(batch.getSize(), static_cast<size_t>(1));
+    EXPECT_NEAR(batch.totalArea(), 2.0, 1e-12);
+}
+
+
+// --- SIMD-ядра: каждый набор инструкций совпадает со скалярным ---
+
+template <size_t N>
+static void CheckKernelsMatchScalar(size_t n) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1000.0, 1000.0);
+    std::vector<std::vector<double>> xs(N, std::vector<double>(n)), ys(N, std::vector<double>(n));
+    const double *px[N], *py[N];
+    for (size_t k = 0; k < N; ++k) {
+        for (size_t i = 0; i < n; ++i) {
+            xs[k][i] = dist(gen);
+            ys[k][i] = dist(gen);
+        }
+        px[k] = xs[k].data();
+        py[k] = ys[k].data();
+    }
+
+    auto scalar = getShoelaceKernels<N>(SimdIsa::Scalar);
+    std::vector<double> areas(n), s(n), cx(n), cy(n);
+    scalar.doubleAreas(px, py, n, areas.data());
+    scalar.centroidSums(px, py, n, s.data(), cx.data(), cy.data());
+
+    for (SimdIsa isa : {SimdIsa::Sse2, SimdIsa::Avx2, SimdIsa::Avx512}) {
+        if (!isSimdIsaSupported(isa))
+            continue;
+        auto kernels = getShoelaceKernels<N>(isa);
+        std::vector<double> areas2(n), s2(n), cx2(n), cy2(n);
+        kernels.doubleAreas(px, py, n, areas2.data());
+        kernels.centroidSums(px, py, n, s2.data(), cx2.data(), cy2.data());
+        EXPECT_EQ(areas, areas2) << "isa " << static_cast<int>(isa);
+        EXPECT_EQ(s, s2) << "isa " << static_cast<int>(isa);
+        EXPECT_EQ(cx, cx2) << "isa " << static_cast<int>(isa);
+        EXPECT_EQ(cy, cy2) << "isa " << static_cast<int>(isa);
+    }
+}
+
+TEST(SimdKernelsTest, QuadrilateralsMatchScalarOnEveryIsa) {
+    CheckKernelsMatchScalar<4>(1003);
+    CheckKernelsMatchScalar<4>(3);
+}
+
+TEST(SimdKernelsTest, PentagonsMatchScalarOnEveryIsa) {
+    CheckKernelsMatchScalar<5>(1003);
+    CheckKernelsMatchScalar<5>(7);
+}
+
+TEST(SimdKernelsTest, ActiveIsaIsSupported) {
+    EXPECT_TRUE(isSimdIsaSupported(activeSimdIsa()));
+    EXPECT_TRUE(isSimdIsaSupported(SimdIsa::Scalar));
+}
+
+
+// --- Параллельные детерминированные редукции ---
+
+TEST(ParallelReduceTest, TotalAreaIsIdenticalForAnyThreadCount) {
+    auto figures = makeMixedFigures(5000);
+    double reference = figures.calcTotalArea(ReduceOptions{1, 64});
+    for (size_t threads : {2, 3, 8}) {
+        EXPECT_EQ(figures.calcTotalArea(ReduceOptions{threads, 64}), reference) << threads;
+    }
+    EXPECT_NEAR(reference, figures.calcTotalArea(), 1e-6 * reference);
+}
+
+TEST(ParallelReduceTest, MinMaxAreaAndMeanCentroid) {
+    auto figures = makeMixedFigures(301);
+    double mn = figures[0]->calcArea(), mx = mn;
+    double cx = 0, cy = 0;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        mn = std::min(mn, figures[i]->calcArea());
+        mx = std::max(mx, figures[i]->calcArea());
+        cx += figures[i]->calcGeometricCenter()[0];
+        cy += figures[i]->calcGeometricCenter()[1];
+    }
+    ReduceOptions options{4, 16};
+    EXPECT_EQ(figures.calcMinArea(options), mn);
+    EXPECT_EQ(figures.calcMaxArea(options), mx);
+
+    auto mean = figures.calcMeanCentroid(options);
+    EXPECT_TRUE(PointsNear(mean, Point<double>(cx / 301, cy / 301), 1e-6));
+    EXPECT_EQ(mean, figures.calcMeanCentroid(ReduceOptions{1, 16}));
+}
+
+TEST(ParallelReduceTest, AreaHistogramCountsEveryFigure) {
+    Figures<Diamond<double>> arr;
+    arr.addFigure(Diamond<double>{ { {0,1}, {1,0}, {0,-1}, {-1,0} } }); // 2
+    arr.addFigure(Diamond<double>{ { {0,2}, {2,0}, {0,-2}, {-2,0} } }); // 8
+    arr.addFigure(Diamond<double>{ { {0,3}, {3,0}, {0,-3}, {-3,0} } }); // 18
+
+    auto hist = arr.calcAreaHistogram(4, 0.0, 16.0, ReduceOptions{2, 1});
+    ASSERT_EQ(hist.size(), static_cast<size_t>(4));
+    EXPECT_EQ(hist[0], static_cast<size_t>(1));
+    EXPECT_EQ(hist[1], static_cast<size_t>(0));
+    EXPECT_EQ(hist[2], static_cast<size_t>(1));
+    EXPECT_EQ(hist[3], static_cast<size_t>(1)); // 18 за границей попадает в последнюю корзину
+
+    Figures<Diamond<double>> empty;
+    EXPECT_EQ(empty.calcTotalArea(ReduceOptions{}), 0.0);
+    EXPECT_EQ(empty.calcMaxArea(), 0.0);
+}
+
+
+// --- Удаление за O(1) и устойчивые дескрипторы ---
+
+TEST(FiguresHandleTest, UnorderedDeleteMovesLastIntoHole) {
+    Figures<Diamond<double>> arr(2);
+    arr.addFigure(Diamond<double>{ { {0,1}, {1,0}, {0,-1}, {-1,0} } }); // 2
+    arr.addFigure(Diamond<double>{ { {0,2}, {2,0}, {0,-2}, {-2,0} } }); // 8
+    arr.addFigure(Diamond<double>{ { {0,3}, {3,0}, {0,-3}, {-3,0} } }); // 18
+
+    arr.deleteFigureUnordered(0);
+    ASSERT_EQ(arr.getSize(), static_cast<size_t>(2));
+    EXPECT_NEAR(arr[0].calcArea(), 18.0, 1e-9);
+    EXPECT_NEAR(arr[1].calcArea(), 8.0, 1e-9);
+
+    arr.deleteFigureUnordered(5); // игнор
+    EXPECT_EQ(arr.getSize(), static_cast<size_t>(2));
+}
+
+TEST(FiguresHandleTest, HandlesSurviveOtherRemovals) {
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    std::vector<FigureHandle> handles;
+    for (int i = 1; i <= 6; ++i) {
+        double d = i;
+        handles.push_back(figures.insertFigure(std::make_shared<Diamond<double>>(
+            std::initializer_list<Point<double>>{{0, d}, {d, 0}, {0, -d}, {-d, 0}})));
+    }
+
+    EXPECT_TRUE(figures.eraseFigure(handles[1]));
+    figures.deleteFigure(0);               // упорядоченное удаление тоже обновляет дескрипторы
+    EXPECT_FALSE(figures.eraseFigure(handles[1]));
+    EXPECT_FALSE(figures.contains(handles[0]));
+    EXPECT_EQ(figures.get(handles[1]), nullptr);
+
+    for (int i = 2; i < 6; ++i) {
+        ASSERT_TRUE(figures.contains(handles[i]));
+        double d = i + 1;
+        EXPECT_NEAR((*figures.get(handles[i]))->calcArea(), 2 * d * d, 1e-9);
+        EXPECT_EQ(figures.handleAt(figures.indexOf(handles[i])), handles[i]);
+    }
+
+    // Освободившийся слот переиспользуется с новым поколением
+    auto h = figures.insertFigure(std::make_shared<Pentagon<double>>(
+        std::initializer_list<Point<double>>{{0, 0}, {2, 0}, {3, 1}, {1.5, 3}, {-0.5, 1}}));
+    EXPECT_TRUE(figures.contains(h));
+    EXPECT_FALSE(figures.contains(handles[0]));
+    EXPECT_FALSE(figures.contains(handles[1]));
+}
+
+TEST(FiguresHandleTest, ReferenceAccessIteratorsAndSpan) {
+    Figures<Trapezoid<double>> arr(1);
+    arr.addFigure(Trapezoid<double>{ { {0,0}, {4,0}, {3,2}, {1,2} } }); // 6
+    arr.addFigure(Trapezoid<double>{ { {0,0}, {6,0}, {4,2}, {2,2} } }); // 8
+
+    const Trapezoid<double> &ref = arr[1];
+    EXPECT_EQ(&ref, &arr.view()[1]);
+
+    double sum = 0;
+    for (const auto &t : arr) sum += t.calcArea();
+    EXPECT_NEAR(sum, 14.0, 1e-9);
+
+    std::span<const Trapezoid<double>> view = std::as_const(arr).view();
+    EXPECT_EQ(view.size(), static_cast<size_t>(2));
+    EXPECT_EQ(view.data(), arr.begin());
+}
+
+
+// --- Арена: пакет фигур за O(1) выделений ---
+
+class CountingResource : public std::pmr::memory_resource {
+  public:
+    size_t allocations = 0;
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        allocations++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST(FigureArenaTest, BatchCostsConstantUpstreamAllocations) {
+    for (size_t n : {10, 1000, 20000}) {
+        CountingResource upstream;
+        {
+            FigureArena arena(n * 256, &upstream);
+            auto figures = arena.makeFigures<std::shared_ptr<Figure<double>>>(n);
+            for (size_t i = 0; i < n; ++i) {
+                double d = static_cast<double>(i + 1);
+                if (i % 2)
+                    figures.addFigure(arena.makeFigure<Diamond<double>>({{0, d}, {d, 0}, {0, -d}, {-d, 0}}));
+                else
+                    figures.addFigure(arena.makeFigure<Pentagon<double>>({{0, 0}, {2, 0}, {3, 1}, {1.5, 3}, {-0.5, 1}}));
+            }
+            ASSERT_EQ(figures.getSize(), n);
+            EXPECT_NEAR(figures[1]->calcArea(), 8.0, 1e-9);
+            EXPECT_NEAR(figures[0]->calcArea(), 6.25, 1e-9);
+        }
+        EXPECT_EQ(upstream.allocations, static_cast<size_t>(1)) << "n = " << n;
+    }
+}
+
+TEST(FigureArenaTest, ValueFiguresGrowInsideArena) {
+    CountingResource upstream;
+    FigureArena arena(1024, &upstream);
+    auto arr = arena.makeFigures<Trapezoid<double>>(1);
+    for (int i = 0; i < 100; ++i) {
+        arr.addFigure(Trapezoid<double>{ { {0,0}, {4,0}, {3,2}, {1,2} } });
+    }
+    EXPECT_EQ(arr.getResource(), arena.resource());
+    EXPECT_NEAR(arr.calcTotalArea(), 600.0, 1e-9);
+    EXPECT_GE(upstream.allocations, static_cast<size_t>(1));
+}
+
+
+// --- VariantFigures: корзины по типам без виртуальных вызовов ---
+
+TEST(VariantFiguresTest, SameApiAsFigures) {
+    VariantFigures<double> figures;
+    figures.addFigure(Pentagon<double>{ { {0,0}, {2,0}, {3,1}, {1.5,3}, {-0.5,1} } }); // 6.25
+    figures.addFigure(Trapezoid<double>{ { {0,0}, {4,0}, {3,2}, {1,2} } });            // 6
+    figures.addFigure(FigureVariant<double>(Diamond<double>{ { {0,1}, {1,0}, {0,-1}, {-1,0} } })); // 2
+
+    EXPECT_EQ(figures.getSize(), static_cast<size_t>(3));
+    EXPECT_NEAR(figures.calcTotalArea(), 14.25, 1e-9);
+
+    // Обход отсортирован по типам: трапеция, ромб, пятиугольник
+    std::vector<int> order;
+    figures.forEach([&order](const auto &fig) { order.push_back(fig.numOfPoints * 10 + static_cast<int>(fig.calcArea())); });
+    EXPECT_EQ(order, (std::vector<int>{46, 42, 56}));
+
+    figures.deleteFigure(1); // ромб
+    EXPECT_EQ(figures.getSize(), static_cast<size_t>(2));
+    EXPECT_TRUE(figures.getBucket<Diamond<double>>().empty());
+    EXPECT_NEAR(figures.calcTotalArea(), 12.25, 1e-9);
+
+    figures.deleteFigure(7); // игнор
+    EXPECT_EQ(figures.getSize(), static_cast<size_t>(2));
+
+    bool isPentagon = false;
+    figures.visit(1, [&isPentagon](const auto &fig) {
+        isPentagon = std::is_same_v<std::decay_t<decltype(fig)>, Pentagon<double>>;
+    });
+    EXPECT_TRUE(isPentagon);
+}
+
+TEST(VariantFiguresTest, PrintMatchesFigures) {
+    VariantFigures<double> figures;
+    figures.addFigure(Diamond<double>{ { {0,1}, {1,0}, {0,-1}, {-1,0} } });
+
+    std::ostringstream captured;
+    auto *old = std::cout.rdbuf(captured.rdbuf());
+    figures.printCenterAndAreaForEachFigure();
+    std::cout.rdbuf(old);
+
+    EXPECT_NE(captured.str().find("(0, 1)"), std::string::npos);
+    EXPECT_NE(captured.str().find("Площадь фигуры: 2"), std::string::npos);
+}
+
+
+// --- Кэш площади, центра и ограничивающего прямоугольника ---
+
+TEST(FigureCacheTest, RepeatedQueriesHitCache) {
+    Pentagon<double> p{ { {0,0}, {2,0}, {3,1}, {1.5,3}, {-0.5,1} } };
+    auto &stats = Figure<double>::cacheStats();
+    stats = {};
+
+    EXPECT_NEAR(p.calcArea(), 6.25, 1e-9);
+    EXPECT_EQ(stats.misses, static_cast<size_t>(1));
+    EXPECT_EQ(stats.hits, static_cast<size_t>(0));
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_NEAR(static_cast<double>(p), 6.25, 1e-9);
+    }
+    EXPECT_EQ(stats.hits, static_cast<size_t>(10));
+
+    auto c1 = p.calcGeometricCenter();
+    auto c2 = p.calcGeometricCenter();
+    EXPECT_EQ(c1, c2);
+    EXPECT_EQ(stats.misses, static_cast<size_t>(2));
+    EXPECT_EQ(stats.hits, static_cast<size_t>(11));
+}
+
+TEST(FigureCacheTest, WritesInvalidateCache) {
+    Trapezoid<double> t{ { {0,0}, {4,0}, {3,2}, {1,2} } };
+    EXPECT_NEAR(t.calcArea(), 6.0, 1e-9);
+    EXPECT_EQ(t.calcBoundingBox(), (BoundingBox<double>{0, 0, 4, 2}));
+
+    t.setPoint(1, Point<double>(6, 0));
+    EXPECT_NEAR(t.calcArea(), 8.0, 1e-9);
+    EXPECT_EQ(t.calcBoundingBox(), (BoundingBox<double>{0, 0, 6, 2}));
+
+    std::istringstream is("0 0  4 0  3 2  1 2");
+    is >> t;
+    EXPECT_NEAR(t.calcArea(), 6.0, 1e-9);
+    EXPECT_TRUE(PointsNear(t.calcGeometricCenter(), Point<double>(2.0, 0.8888888888), 1e-9));
+
+    Trapezoid<double> other{ { {0,0}, {6,0}, {4,2}, {2,2} } };
+    EXPECT_NEAR(other.calcArea(), 8.0, 1e-9);
+    other = t;
+    EXPECT_NEAR(other.calcArea(), 6.0, 1e-9);
+    EXPECT_EQ(other.calcBoundingBox(), (BoundingBox<double>{0, 0, 4, 2}));
+}
+
+
+// --- Двоичный формат и чтение через mmap ---
+
+TEST(FigureFileTest, WriteThenMapWithoutCopy) {
+    auto figures = makeMixedFigures(100);
+    std::string path = ::testing::TempDir() + "figures_test.figb";
+    writeFiguresBinary(path, figures);
+
+    MappedFigureFile<double> file(path);
+    EXPECT_EQ(file.getSize(), figures.getSize());
+    EXPECT_EQ(file.getCount(FigureKind::Trapezoid), static_cast<size_t>(34));
+    EXPECT_EQ(file.getCount(FigureKind::Diamond), static_cast<size_t>(33));
+    EXPECT_EQ(file.getCount(FigureKind::Pentagon), static_cast<size_t>(33));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(file.x(FigureKind::Pentagon, 0).data()) % figureFileAlignment, 0u);
+
+    // Столбцы читаются прямо из отображения
+    auto pentagons = file.view<5>(FigureKind::Pentagon);
+    std::vector<double> s(pentagons.size);
+    pentagons.calcDoubleAreasSigned(s.data());
+    EXPECT_NEAR(std::abs(s[0]) / 2, figures[2]->calcArea(), 1e-9);
+
+    auto diamond = file.getFigure<Diamond<double>>(1);
+    EXPECT_TRUE(diamond == dynamic_cast<const Diamond<double> &>(*figures[4]));
+
+    auto loaded = file.toFigures();
+    EXPECT_EQ(loaded.getSize(), figures.getSize());
+    EXPECT_NEAR(loaded.calcTotalArea(), figures.calcTotalArea(), 1e-6);
+    std::remove(path.c_str());
+}
+
+TEST(FigureFileTest, RejectsWrongScalarTypeAndGarbage) {
+    Figures<Trapezoid<int>> arr;
+    arr.addFigure(Trapezoid<int>{ { {0,0}, {4,0}, {3,2}, {1,2} } });
+    std::string path = ::testing::TempDir() + "figures_int.figb";
+    writeFiguresBinary(path, arr);
+
+    EXPECT_THROW(MappedFigureFile<double>{path}, std::runtime_error);
+    MappedFigureFile<int> file(path);
+    EXPECT_EQ(file.getFigure<Trapezoid<int>>(0), arr[0]);
+
+    std::ofstream(path, std::ios::trunc) << "not a figure file at all, just text.....";
+    EXPECT_THROW(MappedFigureFile<int>{path}, std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(MappedFigureFile<int>{path}, std::runtime_error);
+}
+
+
+TEST(FigureFileTest, RejectsOverflowingCounts) {
+    Figures<Trapezoid<int>> arr;
+    arr.addFigure(Trapezoid<int>{ { {0,0}, {4,0}, {3,2}, {1,2} } });
+    std::string path = ::testing::TempDir() + "figures_corrupt.figb";
+    writeFiguresBinary(path, arr);
+
+    // (2^62 + 1) * 4 байта по модулю 2^64 - те же 4 байта, что у одной фигуры,
+    // поэтому смещения и длина файла сходятся
+    const uint64_t count = (uint64_t{1} << 62) + 1;
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(offsetof(FigureFileHeader, counts));
+        f.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    }
+    EXPECT_THROW(MappedFigureFile<int>{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+// --- Быстрый разбор текста через from_chars ---
+
+TEST(FigureTextTest, ParsesSameFormatAsOperatorIn) {
+    std::string text = "0 0  2 0  3 1  1.5 3  -0.5 1\n"
+                       "0 0\t4 0  5 1  2.5 4  -1 1\r\n";
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    parseFigures<Pentagon<double>>(text, figures);
+    ASSERT_EQ(figures.getSize(), static_cast<size_t>(2));
+
+    std::istringstream is(text);
+    Pentagon<double> a, b;
+    is >> a >> b;
+    EXPECT_TRUE(dynamic_cast<const Pentagon<double> &>(*figures[0]) == a);
+    EXPECT_TRUE(dynamic_cast<const Pentagon<double> &>(*figures[1]) == b);
+
+    Figures<Trapezoid<int>> ints;
+    parseFigures<Trapezoid<int>>("0 0 4 0 3 2 1 2", ints);
+    EXPECT_NEAR(ints.calcTotalArea(), 6.0, 1e-9);
+}
+
+TEST(FigureTextTest, ReportsLineAndColumn) {
+    Figures<Trapezoid<double>> figures;
+    try {
+        parseFigures<Trapezoid<double>>("0 0 4 0 3 2 1 2\n0 0 4 x 3 2 1 2\n", figures);
+        FAIL() << "ожидалось исключение";
+    } catch (const FigureParseError &e) {
+        EXPECT_EQ(e.getLine(), static_cast<size_t>(2));
+        EXPECT_EQ(e.getColumn(), static_cast<size_t>(7));
+    }
+
+    try {
+        parseFigures<Trapezoid<double>>("0 0 4 0\n3 2", figures);
+        FAIL() << "ожидалось исключение";
+    } catch (const FigureParseError &e) {
+        EXPECT_EQ(e.getLine(), static_cast<size_t>(2));
+        EXPECT_NE(std::string(e.what()).find("конец"), std::string::npos);
+    }
+}
+
+TEST(FigureTextTest, LoadsWholeFile) {
+    std::string path = ::testing::TempDir() + "figures_text.txt";
+    std::ofstream(path) << "0 1 1 0 0 -1 -1 0\n0 2 2 0 0 -2 -2 0\n";
+    auto figures = loadFigures<Diamond<double>>(path);
+    EXPECT_EQ(figures.getSize(), static_cast<size_t>(2));
+    EXPECT_NEAR(figures.calcTotalArea(), 10.0, 1e-9);
+    std::remove(path.c_str());
+    EXPECT_THROW(loadFigures<Diamond<double>>(path), std::runtime_error);
+    // Каталог открывается, но tellg для него бессмыслен, а read не проходит
+    EXPECT_THROW(loadFigures<Diamond<double>>(::testing::TempDir()), std::runtime_error);
+}
+
+
+// --- Буферизованные отчёты: текст, CSV, JSON Lines ---
+
+TEST(FigureReportTest, TextMatchesStreamOutput) {
+    auto figures = makeMixedFigures(5);
+    std::ostringstream expected;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        expected << *figures[i] << "Геометрический центр: " << figures[i]->calcGeometricCenter() << '\n';
+        expected << "Площадь фигуры: " << figures[i]->calcArea() << "\n\n";
+    }
+
+    std::ostringstream os;
+    std::string buffer;
+    {
+        ReportWriter writer(os, ReportFormat::Text, buffer);
+        figures.writeReport(writer);
+    }
+    EXPECT_EQ(os.str(), expected.str());
+}
+
+// Формат чисел в Text берётся из потока так же, как у operator<<
+TEST(FigureReportTest, TextFollowsStreamFormatting) {
+    auto figures = makeMixedFigures(5);
+    figures.addFigure(std::make_shared<Trapezoid<double>>(std::initializer_list<Point<double>>{
+        {-1e300, 0}, {1e300, 0}, {1e300, 1e-300}, {-1e300, 1e-300}}));
+    Figures<Trapezoid<int>> ints;
+    ints.addFigure(Trapezoid<int>{ { {-7, -3}, {255, -3}, {100, 40}, {-2, 40} } });
+
+    auto configure = [](std::ostream &os, int variant) {
+        switch (variant) {
+        case 0: os << std::fixed << std::setprecision(2); break;
+        case 1: os << std::scientific << std::uppercase << std::setprecision(10); break;
+        case 2: os << std::hexfloat; break;
+        case 3: os << std::setprecision(17); break;
+        case 4: os << std::hex; break;
+        case 5: os << std::oct << std::setprecision(0); break;
+        }
+    };
+    for (int variant = 0; variant < 6; ++variant) {
+        std::ostringstream expected, os;
+        configure(expected, variant);
+        configure(os, variant);
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            expected << *figures[i] << "Площадь фигуры: " << figures[i]->calcArea() << "\n\n";
+        }
+        expected << ints[0] << "Геометрический центр: " << ints[0].calcGeometricCenter() << "\n\n";
+        std::string buffer;
+        {
+            ReportWriter writer(os, ReportFormat::Text, buffer, ReportArea);
+            figures.writeReport(writer);
+        }
+        {
+            ReportWriter writer(os, ReportFormat::Text, buffer, ReportCenter);
+            ints.writeReport(writer);
+        }
+        EXPECT_EQ(os.str(), expected.str()) << "вариант " << variant;
+    }
+}
+
+TEST(FigureReportTest, CsvAndJsonLines) {
+    Figures<Trapezoid<double>> arr;
+    arr.addFigure(Trapezoid<double>{ { {0,0}, {4,0}, {3,2}, {1,2} } });
+    arr.addFigure(Trapezoid<double>{ { {0,0}, {2,0}, {1.5,1}, {0.5,1} } });
+
+    std::ostringstream csv;
+    std::string buffer;
+    {
+        ReportWriter writer(csv, ReportFormat::Csv, buffer, ReportArea);
+        arr.writeReport(writer);
+    }
+    EXPECT_EQ(csv.str(), "index,kind,area\n0,trapezoid,6\n1,trapezoid,1.5\n");
+
+    std::ostringstream json;
+    {
+        ReportWriter writer(json, ReportFormat::JsonLines, buffer);
+        arr.writeReport(writer);
+    }
+    std::string first = json.str().substr(0, json.str().find('\n'));
+    EXPECT_EQ(first, "{\"index\":0,\"kind\":\"trapezoid\",\"points\":[[0,0],[4,0],[3,2],[1,2]],"
+                     "\"center\":[2,0.8888888888888888],\"area\":6}");
+}
+
+TEST(FigureReportTest, FlushesInLargeChunksAndReusesBuffer) {
+    auto figures = makeMixedFigures(200);
+    std::vector<size_t> chunks;
+    std::string out;
+    std::string buffer;
+    {
+        ReportWriter writer([&](std::string_view chunk) {
+            chunks.push_back(chunk.size());
+            out.append(chunk);
+        }, ReportFormat::JsonLines, buffer, ReportCenterAndArea, 4096);
+        figures.writeReport(writer);
+    }
+    EXPECT_EQ(static_cast<size_t>(std::count(out.begin(), out.end(), '\n')), static_cast<size_t>(200));
+    ASSERT_GT(chunks.size(), static_cast<size_t>(1));
+    for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+        EXPECT_GE(chunks[i], static_cast<size_t>(4096));
+    }
+    EXPECT_GE(buffer.capacity(), static_cast<size_t>(4096));
+    EXPECT_TRUE(buffer.empty());
+}
+
+
+// --- Пространственный индекс ---
+
+template <class U>
+static std::vector<FigureHandle> BruteForceWindow(const Figures<U> &figures, const BoundingBox<double> &window) {
+    std::vector<FigureHandle> out;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        if (Figures<U>::deref(figures[i]).calcBoundingBox().intersects(window))
+            out.push_back(figures.handleAt(i));
+    }
+    return out;
+}
+
+static void SortHandles(std::vector<FigureHandle> &v) {
+    std::sort(v.begin(), v.end(), [](const FigureHandle &a, const FigureHandle &b) { return a.slot < b.slot; });
+}
+
+TEST(SpatialIndexTest, WindowAndPointQueriesMatchBruteForce) {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> pos(-50.0, 50.0), size(0.1, 4.0);
+    IndexedFigures<Diamond<double>> indexed(2.0);
+    for (int i = 0; i < 500; ++i) {
+        double x = pos(gen), y = pos(gen), r = size(gen);
+        indexed.addFigure(Diamond<double>{ { {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y} } });
+    }
+    // Удаления по индексу и по дескриптору поддерживают сетку в актуальном состоянии
+    for (int i = 0; i < 100; ++i) {
+        indexed.deleteFigure(i * 3);
+    }
+    indexed.eraseFigure(indexed.getFigures().handleAt(0));
+    EXPECT_EQ(indexed.getGrid().getSize(), indexed.getFigures().getSize());
+
+    for (int q = 0; q < 50; ++q) {
+        double x = pos(gen), y = pos(gen), w = size(gen) * 3;
+        BoundingBox<double> window{x, y, x + w, y + w};
+        auto fast = indexed.queryWindow(window);
+        auto slow = BruteForceWindow(indexed.getFigures(), window);
+        SortHandles(fast);
+        SortHandles(slow);
+        EXPECT_EQ(fast, slow);
+
+        auto stab = indexed.queryPoint(Point<double>(x, y));
+        auto stabSlow = BruteForceWindow(indexed.getFigures(), BoundingBox<double>{x, y, x, y});
+        SortHandles(stab);
+        SortHandles(stabSlow);
+        EXPECT_EQ(stab, stabSlow);
+    }
+}
+
+TEST(SpatialIndexTest, RefreshAfterMutationAndBulkBuild) {
+    IndexedFigures<Trapezoid<double>> indexed(1.0);
+    auto h = indexed.addFigure(Trapezoid<double>{ { {0,0}, {4,0}, {3,2}, {1,2} } });
+    EXPECT_EQ(indexed.queryPoint(Point<double>(2, 1)).size(), static_cast<size_t>(1));
+
+    indexed.getFigures().get(h)->setPoint(0, Point<double>(10, 0));
+    indexed.refresh(h);
+    EXPECT_EQ(indexed.queryPoint(Point<double>(9, 0)).size(), static_cast<size_t>(1));
+    EXPECT_TRUE(indexed.queryWindow(BoundingBox<double>{-5, -5, -1, -1}).empty());
+
+    auto figures = makeMixedFigures(60);
+    SpatialGrid<double> grid(SpatialGrid<double>::suggestCellSize(figures));
+    grid.build(figures);
+    EXPECT_EQ(grid.getSize(), figures.getSize());
+    std::vector<FigureHandle> all;
+    grid.queryWindow(BoundingBox<double>{-1e3, -1e3, 1e3, 1e3}, all);
+    EXPECT_EQ(all.size(), figures.getSize());
+}
+
+TEST(SpatialIndexTest, ExtremeCoordinatesAndHugeWindows) {
+    // Далеко за пределами int32 в ячейках, огромная фигура и бесконечное окно:
+    // номера ячеек ограничены, обход окна не зависит от его площади
+    IndexedFigures<Trapezoid<double>> indexed(1.0);
+    auto nearOrigin = indexed.addFigure(Trapezoid<double>{ { {0, 0}, {2, 0}, {2, 1}, {0, 1} } });
+    auto far = indexed.addFigure(Trapezoid<double>{ { {3e9, 3e9}, {3e9 + 2, 3e9}, {3e9 + 2, 3e9 + 1}, {3e9, 3e9 + 1} } });
+    auto huge = indexed.addFigure(Trapezoid<double>{ { {-1e300, -1e300}, {1e300, -1e300}, {1e300, 1e300}, {-1e300, 1e300} } });
+
+    auto all = indexed.queryWindow(BoundingBox<double>{-INFINITY, -INFINITY, INFINITY, INFINITY});
+    SortHandles(all);
+    EXPECT_EQ(all, (std::vector<FigureHandle>{nearOrigin, far, huge}));
+    EXPECT_EQ(indexed.queryWindow(BoundingBox<double>{-1e18, -1e18, 1e18, 1e18}).size(), static_cast<size_t>(3));
+    EXPECT_EQ(indexed.queryWindow(BoundingBox<double>{5, 5, 1e6, 1e6}), std::vector<FigureHandle>{huge});
+
+    auto stab = indexed.queryPoint(Point<double>(3e9 + 1, 3e9 + 0.5));
+    SortHandles(stab);
+    EXPECT_EQ(stab, (std::vector<FigureHandle>{far, huge}));
+
+    EXPECT_TRUE(indexed.eraseFigure(huge));
+    EXPECT_TRUE(indexed.queryWindow(BoundingBox<double>{5, 5, 1e6, 1e6}).empty());
+    EXPECT_EQ(indexed.getGrid().getSize(), static_cast<size_t>(2));
+}
+
+
+// --- Пакетная проверка точек на принадлежность фигурам ---
+
+// Эталон: знак ориентации относительно каждого ребра выпуклой фигуры
+template <class Fig>
+static bool InsideConvex(const Fig &fig, const Point<double> &p) {
+    auto pts = fig.getPoints();
+    int sign = 0;
+    for (size_t k = 0; k < pts.size(); ++k) {
+        const auto &a = pts[k];
+        const auto &b = pts[(k + 1) % pts.size()];
+        double cross = (b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]);
+        int s = cross > 0 ? 1 : -1;
+        if (sign != 0 && s != sign) return false;
+        sign = s;
+    }
+    return true;
+}
+
+TEST(ContainmentTest, MatchesPerPointLoop) {
+    auto figures = makeMixedFigures(40);
+    ContainmentEngine<double> engine(figures);
+    ASSERT_EQ(engine.getSize(), figures.getSize());
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(-45.0, 45.0);
+    std::vector<Point<double>> points;
+    for (int i = 0; i < 3000; ++i) {
+        points.emplace_back(dist(gen), dist(gen) / 3);
+    }
+
+    auto result = engine.classify(points, ReduceOptions{3, 4});
+    ASSERT_EQ(result.getNumFigures(), figures.getSize());
+    size_t total = 0;
+    for (size_t f = 0; f < figures.getSize(); ++f) {
+        size_t expected = 0;
+        for (size_t p = 0; p < points.size(); ++p) {
+            bool inside = InsideConvex(*figures[f], points[p]);
+            expected += inside;
+            ASSERT_EQ(result.contains(f, p), inside) << "figure " << f << " point " << p;
+        }
+        EXPECT_EQ(result.countInside(f), expected);
+        EXPECT_EQ(result.pointsInside(f).size(), expected);
+        total += expected;
+    }
+    EXPECT_GT(total, static_cast<size_t>(0));
+}
+
+TEST(ContainmentTest, IndexListsForSimpleDiamond) {
+    Figures<Diamond<int>> arr;
+    arr.addFigure(Diamond<int>{ { {0,2}, {2,0}, {0,-2}, {-2,0} } });
+    ContainmentEngine<int> engine(arr);
+    std::vector<Point<int>> points{{0, 0}, {5, 5}, {1, 0}, {-3, 0}, {0, 1}};
+    auto result = engine.classify(points);
+    auto inside = result.pointsInside(0);
+    EXPECT_EQ(std::vector<uint32_t>(inside.begin(), inside.end()), (std::vector<uint32_t>{0, 2, 4}));
+    EXPECT_EQ(result.getNumFigures(), 1u);
+    EXPECT_EQ(result.getNumPoints(), points.size());
+}
+
+
+// --- Попарные пересечения фигур ---
+
+TEST(OverlapTest, IntersectionAreaOfSquares) {
+    Trapezoid<double> a{ {0, 0}, {2, 0}, {2, 2}, {0, 2} };
+    Trapezoid<double> b{ {1, 1}, {3, 1}, {3, 3}, {1, 3} };
+    Trapezoid<double> cw{ {1, 3}, {3, 3}, {3, 1}, {1, 1} };
+    Trapezoid<double> far{ {5, 5}, {6, 5}, {6, 6}, {5, 6} };
+    Trapezoid<double> touching{ {2, 0}, {4, 0}, {4, 2}, {2, 2} };
+    EXPECT_DOUBLE_EQ(intersectionArea(a, b), 1.0);
+    EXPECT_DOUBLE_EQ(intersectionArea(a, cw), 1.0);
+    EXPECT_DOUBLE_EQ(intersectionArea(a, a), 4.0);
+    EXPECT_DOUBLE_EQ(intersectionArea(a, far), 0.0);
+    EXPECT_DOUBLE_EQ(intersectionArea(a, touching), 0.0);
+
+    Diamond<double> d{ {1, 2}, {2, 1}, {1, 0}, {0, 1} };
+    Pentagon<double> p{ {0, 0}, {2, 0}, {2, 1}, {1, 2}, {0, 1} };
+    EXPECT_DOUBLE_EQ(intersectionArea<double>(d, a), 2.0);
+    EXPECT_DOUBLE_EQ(intersectionArea<double>(p, a), 3.0);
+    EXPECT_DOUBLE_EQ(intersectionArea<double>(p, b), 0.5);
+}
+
+TEST(OverlapTest, MatchesAllPairsLoop) {
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> pos(0, 40), size(0.5, 4);
+    for (int i = 0; i < 150; ++i) {
+        double x = pos(gen), y = pos(gen), r = size(gen);
+        if (i % 2 == 0)
+            figures.addFigure(std::make_shared<Diamond<double>>(std::initializer_list<Point<double>>{
+                {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y}}));
+        else
+            figures.addFigure(std::make_shared<Pentagon<double>>(std::initializer_list<Point<double>>{
+                {x, y}, {x + r, y}, {x + 1.5 * r, y + r}, {x + r / 2, y + 2 * r}, {x - r / 2, y + r}}));
+    }
+
+    std::vector<FigureOverlap> expected;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        for (size_t j = i + 1; j < figures.getSize(); ++j) {
+            double area = intersectionArea(*figures[i], *figures[j]);
+            if (area > 0)
+                expected.push_back({i, j, area});
+        }
+    }
+    ASSERT_FALSE(expected.empty());
+
+    auto overlaps = findOverlaps(figures, ReduceOptions{4, 8});
+    ASSERT_EQ(overlaps.size(), expected.size());
+    for (size_t k = 0; k < overlaps.size(); ++k) {
+        EXPECT_EQ(overlaps[k].first, expected[k].first);
+        EXPECT_EQ(overlaps[k].second, expected[k].second);
+        EXPECT_NEAR(overlaps[k].area, expected[k].area, 1e-9);
+    }
+    EXPECT_EQ(findOverlaps(figures, ReduceOptions{1, 8}), overlaps);
+}
+
+
+// --- Площадь объединения ---
+
+TEST(UnionAreaTest, SimpleCases) {
+    Figures<Trapezoid<double>> squares;
+    EXPECT_DOUBLE_EQ(squares.calcUnionArea(), 0.0);
+    squares.addFigure(Trapezoid<double>{ {0, 0}, {2, 0}, {2, 2}, {0, 2} });
+    EXPECT_DOUBLE_EQ(squares.calcUnionArea(), 4.0);
+    squares.addFigure(Trapezoid<double>{ {1, 1}, {3, 1}, {3, 3}, {1, 3} });
+    EXPECT_DOUBLE_EQ(squares.calcUnionArea(), 7.0);
+    squares.addFigure(Trapezoid<double>{ {0, 0}, {2, 0}, {2, 2}, {0, 2} });
+    EXPECT_DOUBLE_EQ(squares.calcUnionArea(), 7.0);
+    squares.addFigure(Trapezoid<double>{ {10, 0}, {11, 0}, {11, 1}, {10, 1} });
+    EXPECT_DOUBLE_EQ(squares.calcUnionArea(), 8.0);
+
+    // Ромб, вписанный в квадрат, ничего не добавляет
+    Figures<std::shared_ptr<Figure<double>>> mixed;
+    mixed.addFigure(std::make_shared<Trapezoid<double>>(std::initializer_list<Point<double>>{
+        {0, 0}, {2, 0}, {2, 2}, {0, 2}}));
+    mixed.addFigure(std::make_shared<Diamond<double>>(std::initializer_list<Point<double>>{
+        {1, 2}, {2, 1}, {1, 0}, {0, 1}}));
+    EXPECT_NEAR(mixed.calcUnionArea(), 4.0, 1e-12);
+}
+
+// Формула включений-исключений: пересечение выпуклых фигур выпукло
+static double InclusionExclusion(const std::vector<ConvexPolygon> &polys) {
+    double total = 0;
+    for (size_t mask = 1; mask < (size_t{1} << polys.size()); ++mask) {
+        ConvexPolygon common;
+        bool first = true;
+        for (size_t i = 0; i < polys.size(); ++i) {
+            if (!(mask >> i & 1))
+                continue;
+            common = first ? polys[i] : clipConvex(common, polys[i]);
+            first = false;
+        }
+        double area = common.size < 3 ? 0 : std::abs(common.areaSigned());
+        total += (std::popcount(mask) % 2 ? 1 : -1) * area;
+    }
+    return total;
+}
+
+TEST(UnionAreaTest, MatchesInclusionExclusion) {
+    std::mt19937 gen(8);
+    std::uniform_real_distribution<double> pos(0, 6), size(1, 3);
+    for (int round = 0; round < 20; ++round) {
+        Figures<std::shared_ptr<Figure<double>>> figures;
+        std::vector<ConvexPolygon> polys;
+        for (int i = 0; i < 7; ++i) {
+            double x = pos(gen), y = pos(gen), r = size(gen);
+            if (i % 2 == 0)
+                figures.addFigure(std::make_shared<Diamond<double>>(std::initializer_list<Point<double>>{
+                    {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y}}));
+            else
+                figures.addFigure(std::make_shared<Pentagon<double>>(std::initializer_list<Point<double>>{
+                    {x, y}, {x + r, y}, {x + 1.5 * r, y + r}, {x + r / 2, y + 2 * r}, {x - r / 2, y + r}}));
+            polys.push_back(ConvexPolygon::from(*figures[i]));
+        }
+        EXPECT_NEAR(figures.calcUnionArea(), InclusionExclusion(polys), 1e-9);
+    }
+}
+
+TEST(UnionAreaTest, IndependentOfThreadCount) {
+    auto figures = makeMixedFigures(60);
+    double single = figures.calcUnionArea(ReduceOptions{1, 16});
+    EXPECT_EQ(figures.calcUnionArea(ReduceOptions{4, 16}), single);
+    EXPECT_EQ(figures.calcUnionArea(ReduceOptions{3, 16}), single);
+    EXPECT_NEAR(figures.calcUnionArea(), single, 1e-9 * single);
+    EXPECT_LT(single, figures.calcTotalArea());
+}
+
+static ConvexPolygon LatticePolygon(std::initializer_list<std::pair<int, int>> points) {
+    ConvexPolygon poly;
+    for (auto [x, y] : points) {
+        poly.push(x, y);
+    }
+    return poly;
+}
+
+// Целые координаты: общие вершины, совпадающие рёбра и пересечения разных пар
+// рёбер в одной точке, которые в double расходятся на ulp
+TEST(UnionAreaTest, LatticeInputsMatchInclusionExclusion) {
+    const std::vector<ConvexPolygon> nearlyCoincident = {
+        LatticePolygon({{3, 0}, {5, -3}, {7, 0}, {5, 3}}),
+        LatticePolygon({{1, 1}, {2, -2}, {3, 1}, {2, 4}}),
+        LatticePolygon({{1, 0}, {4, -1}, {7, 0}, {4, 1}}),
+    };
+    EXPECT_NEAR(unionArea(nearlyCoincident), InclusionExclusion(nearlyCoincident), 1e-12);
+
+    const std::vector<ConvexPolygon> sharedVertices = {
+        LatticePolygon({{0, 0}, {2, 0}, {2, 2}, {0, 2}}),
+        LatticePolygon({{2, 2}, {4, 2}, {4, 4}, {2, 4}}),
+        LatticePolygon({{2, 0}, {4, 2}, {2, 4}, {0, 2}}),
+        LatticePolygon({{0, 2}, {2, 2}, {2, 4}, {0, 4}}),
+    };
+    EXPECT_NEAR(unionArea(sharedVertices), InclusionExclusion(sharedVertices), 1e-12);
+
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> pos(0, 8), size(1, 3);
+    for (int round = 0; round < 500; ++round) {
+        std::vector<ConvexPolygon> polys;
+        for (int i = 0; i < 2 + round % 5; ++i) {
+            int x = pos(gen), y = pos(gen), rx = size(gen), ry = size(gen), skew = size(gen) - 2;
+            polys.push_back(LatticePolygon({{x - rx, y + skew}, {x, y - ry}, {x + rx, y - skew}, {x, y + ry}}));
+        }
+        const double expected = InclusionExclusion(polys);
+        EXPECT_NEAR(unionArea(polys), expected, 1e-9 * (1 + expected)) << round;
+        EXPECT_NEAR(unionArea(polys, ReduceOptions{1, 2}), expected, 1e-9 * (1 + expected)) << round;
+    }
+}
+
+TEST(UnionAreaTest, NonConvexSimpleFigure) {
+    // Стрелка площади 10 с вырезом сверху и квадрат 2x3, заходящий в вырез:
+    // общая часть - два треугольника по 1/12
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    figures.addFigure(std::make_shared<Pentagon<double>>(std::initializer_list<Point<double>>{
+        {0, 0}, {4, 0}, {4, 4}, {2, 1}, {0, 4}}));
+    figures.addFigure(std::make_shared<Trapezoid<double>>(std::initializer_list<Point<double>>{
+        {1, 2}, {3, 2}, {3, 5}, {1, 5}}));
+    EXPECT_NEAR(figures.calcUnionArea(), 10.0 + 6.0 - 1.0 / 6, 1e-12);
+}
+
+TEST(UnionAreaTest, RejectsSelfIntersecting) {
+    Figures<Trapezoid<double>> figures;
+    figures.addFigure(Trapezoid<double>{ {0, 0}, {2, 0}, {2, 2}, {0, 2} });
+    figures.addFigure(Trapezoid<double>{ {0, 0}, {2, 2}, {2, 0}, {0, 2} });
+    EXPECT_THROW(figures.calcUnionArea(), std::invalid_argument);
+
+    Figures<Trapezoid<double>> infinite;
+    infinite.addFigure(Trapezoid<double>{ {0, 0}, {INFINITY, 0}, {2, 2}, {0, 2} });
+    EXPECT_THROW(infinite.calcUnionArea(), std::invalid_argument);
+}
+
+
+// --- Аффинные преобразования ---
+
+TEST(AffineTest, CompositionAndDeterminant) {
+    Affine2 m = Affine2::translation(1, 2) * Affine2::scaling(2, 3);
+    EXPECT_EQ(m.apply(Point<double>(1, 1)), Point<double>(3, 5));
+    EXPECT_DOUBLE_EQ(m.determinant(), 6.0);
+    EXPECT_NEAR(Affine2::rotation(0.7).determinant(), 1.0, 1e-15);
+    EXPECT_EQ(Affine2::identity() * m, m);
+    EXPECT_EQ(Affine2::scaling(2, 2).apply(Point<int>(3, -4)), Point<int>(6, -8));
+    EXPECT_EQ(Affine2::scaling(0.5, 0.5).apply(Point<int>(3, -3)), Point<int>(2, -2));
+}
+
+TEST(AffineTest, FigureTransformUpdatesCacheIncrementally) {
+    Pentagon<double> p{ {0, 0}, {2, 0}, {3, 1}, {1.5, 3}, {-0.5, 1} };
+    p.warmCache();
+    Affine2 m = Affine2::translation(5, -1) * Affine2::rotation(0.3) * Affine2::scaling(2, -1.5);
+
+    Pentagon<double> expected;
+    for (size_t k = 0; k < 5; ++k) {
+        expected.setPoint(k, m.apply(p.getPoint(k)));
+    }
+
+    p.transform(m);
+    EXPECT_EQ(p, expected);
+    auto before = Figure<double>::cacheStats();
+    double area = p.calcAreaSigned();
+    auto center = p.calcGeometricCenter();
+    auto box = p.calcBoundingBox();
+    auto after = Figure<double>::cacheStats();
+    EXPECT_EQ(after.misses, before.misses);
+
+    EXPECT_NEAR(area, expected.calcAreaSigned(), 1e-12);
+    EXPECT_LT(area, 0);   // отражение меняет обход
+    EXPECT_TRUE(PointsNear(center, expected.calcGeometricCenter(), 1e-12));
+    EXPECT_EQ(box, expected.calcBoundingBox());
+}
+
+TEST(AffineTest, IntegerFigureIsRecomputed) {
+    Trapezoid<int> t{ {0, 0}, {4, 0}, {3, 2}, {1, 2} };
+    EXPECT_DOUBLE_EQ(t.calcArea(), 6.0);
+    t.transform(Affine2::translation(10, 20) * Affine2::scaling(2, 2));
+    EXPECT_EQ(t, (Trapezoid<int>{ {10, 20}, {18, 20}, {16, 24}, {12, 24} }));
+    EXPECT_DOUBLE_EQ(t.calcArea(), 24.0);
+    EXPECT_EQ(t.calcBoundingBox(), (BoundingBox<int>{10, 20, 18, 24}));
+}
+
+TEST(AffineTest, CollectionAndBatchTransforms) {
+    auto figures = makeMixedFigures(101);
+    FigureBatch<double> batch(figures);
+    auto areas = batch.areas();
+    Affine2 m = Affine2::rotation(1.1) * Affine2::scaling(1.5, 0.5) * Affine2::translation(-3, 4);
+
+    std::vector<std::vector<Point<double>>> expected;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        std::vector<Point<double>> pts;
+        for (const auto &p : figures[i]->getPoints()) {
+            pts.push_back(m.apply(p));
+        }
+        expected.push_back(pts);
+    }
+
+    figures.transform(m, ReduceOptions{4, 8});
+    batch.transform(m, ReduceOptions{3, 8});
+    auto batchAreas = batch.areas();
+    auto batchCenters = batch.centroids();
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        auto pts = figures[i]->getPoints();
+        EXPECT_TRUE(std::equal(pts.begin(), pts.end(), expected[i].begin())) << i;
+        EXPECT_NEAR(batchAreas[i], areas[i] * std::abs(m.determinant()), 1e-9 * (1 + areas[i]));
+        EXPECT_NEAR(figures[i]->calcArea(), batchAreas[i], 1e-9 * (1 + areas[i]));
+        EXPECT_TRUE(PointsNear(batchCenters[i], figures[i]->calcGeometricCenter(), 1e-9));
+    }
+}
+
+TEST(AffineTest, KernelsMatchScalarOnEveryIsa) {
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> dist(-1000.0, 1000.0);
+    const double m[6] = {0.8, -0.6, 12.5, 0.6, 0.8, -3.25};
+    for (size_t n : {1003u, 5u}) {
+        std::vector<double> x(n), y(n);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = dist(gen);
+            y[i] = dist(gen);
+        }
+        auto sx = x, sy = y;
+        getAffineKernel(SimdIsa::Scalar)(m, sx.data(), sy.data(), n);
+        for (SimdIsa isa : {SimdIsa::Sse2, SimdIsa::Avx2, SimdIsa::Avx512}) {
+            if (!isSimdIsaSupported(isa))
+                continue;
+            auto vx = x, vy = y;
+            getAffineKernel(isa)(m, vx.data(), vy.data(), n);
+            EXPECT_EQ(vx, sx) << "isa " << static_cast<int>(isa);
+            EXPECT_EQ(vy, sy) << "isa " << static_cast<int>(isa);
+        }
+    }
+}
+
+
+// --- Перемещение без выделений памяти ---
+
+static_assert(std::is_nothrow_move_constructible_v<Trapezoid<double>>);
+static_assert(std::is_nothrow_move_assignable_v<Diamond<int>>);
+static_assert(std::is_nothrow_move_constructible_v<Pentagon<float>>);
+static_assert(std::is_nothrow_copy_assignable_v<Pentagon<double>>);
+
+TEST(MoveTest, AllocScopeCountsNestedAllocations) {
+    AllocScope outer;
+    {
+        AllocScope inner;
+        auto p = std::make_unique<int>(1);
+        EXPECT_EQ(inner.getCount(), 1u);
+        EXPECT_GE(inner.getBytes(), sizeof(int));
+    }
+    std::vector<int> v(10);
+    EXPECT_EQ(outer.getCount(), 2u);
+}
+
+TEST(MoveTest, MovesKeepPointsAndCacheWithoutAllocations) {
+    Pentagon<double> source{ {0, 0}, {2, 0}, {3, 1}, {1.5, 3}, {-0.5, 1} };
+    const Pentagon<double> original = source;
+    source.warmCache();
+
+    AllocScope scope;
+    Pentagon<double> moved(std::move(source));
+    Pentagon<double> assigned;
+    assigned = std::move(moved);
+    Diamond<int> d1{ {0, 1}, {1, 0}, {0, -1}, {-1, 0} };
+    Diamond<int> d2(std::move(d1));
+    Trapezoid<float> t1{ {0, 0}, {4, 0}, {3, 2}, {1, 2} };
+    Trapezoid<float> t2;
+    t2 = std::move(t1);
+    EXPECT_EQ(scope.getCount(), 0u);
+
+    EXPECT_EQ(assigned, original);
+    EXPECT_EQ(assigned.getPoints().data(), &assigned.getPoint(0));
+    const double area = original.calcArea();
+    auto before = Figure<double>::cacheStats();
+    EXPECT_DOUBLE_EQ(assigned.calcArea(), area);
+    EXPECT_EQ(Figure<double>::cacheStats().misses, before.misses);
+    EXPECT_EQ(d2.calcArea(), 2.0);
+    EXPECT_EQ(t2.calcArea(), 6.0);
+}
+
+TEST(MoveTest, FiguresGrowthAllocatesPerResizeNotPerVertex) {
+    const size_t n = 1 << 12;
+    Pentagon<double> fig{ {0, 0}, {2, 0}, {3, 1}, {1.5, 3}, {-0.5, 1} };
+    Figures<Pentagon<double>> figures;
+
+    AllocScope scope;
+    for (size_t i = 0; i < n; ++i) {
+        figures.addFigure(fig);
+    }
+    // Удвоение массива и служебных таблиц: O(log n) выделений на всю серию
+    EXPECT_LE(scope.getCount(), 5 * 14u);
+
+    AllocScope deletes;
+    figures.deleteFigure(0);
+    figures.deleteFigureUnordered(7);
+    EXPECT_LE(deletes.getCount(), 2u);   // только рост списка свободных слотов
+    EXPECT_EQ(figures[0], fig);
+}
+
+
+// --- constexpr-фигуры ---
+
+constexpr FixedTrapezoid<double> referenceTrapezoid{ {0, 0}, {4, 0}, {3, 2}, {1, 2} };
+constexpr FixedDiamond<int> referenceDiamond{ {0, 2}, {3, 0}, {0, -2}, {-3, 0} };
+constexpr FixedPentagon<double> referencePentagon{ {0, 0}, {2, 0}, {2, 1}, {1, 2}, {0, 1} };
+
+static_assert(referenceTrapezoid.calcArea() == 6.0);
+static_assert(referenceTrapezoid.calcGeometricCenter() == Point<double>(2, 8.0 / 9));
+static_assert(referenceDiamond.calcArea() == 12.0);
+static_assert(referenceDiamond.calcAreaSigned() == -12.0);
+static_assert(referenceDiamond.calcGeometricCenter() == Point<int>(0, 0));
+static_assert(referencePentagon.calcArea() == 3.0);
+static_assert(referencePentagon.calcBoundingBox() == BoundingBox<double>{0, 0, 2, 2});
+static_assert(referencePentagon == FixedPentagon<double>{ {0, 0}, {2, 0}, {2, 1}, {1, 2}, {0, 1} });
+static_assert(referencePentagon != FixedPentagon<double>{ {0, 0}, {2, 0}, {2, 1}, {1, 3}, {0, 1} });
+static_assert(FixedPentagon<double>::numOfPoints == 5 && FixedDiamond<int>::figureKind == FigureKind::Diamond);
+
+TEST(FixedShapeTest, MatchesRuntimeFigures) {
+    Trapezoid<double> t = referenceTrapezoid.toFigure();
+    EXPECT_EQ(t.calcArea(), referenceTrapezoid.calcArea());
+    EXPECT_EQ(t.calcGeometricCenter(), referenceTrapezoid.calcGeometricCenter());
+
+    auto figures = makeMixedFigures(30);
+    for (size_t i = 2; i < figures.getSize(); i += 3) {
+        const auto &p = static_cast<const Pentagon<double> &>(*figures[i]);
+        FixedPentagon<double> fixed(p);
+        EXPECT_EQ(fixed.calcAreaSigned(), p.calcAreaSigned());
+        EXPECT_EQ(fixed.calcGeometricCenter(), p.calcGeometricCenter());
+        EXPECT_EQ(fixed.calcBoundingBox(), p.calcBoundingBox());
+        EXPECT_EQ(fixed.toFigure(), p);
+    }
+}
+
+
+TEST(FixedShapeTest, LargeIntegersMatchExactFigure) {
+    // Произведения координат ~1e5 не помещаются в int
+    const int s = 100'000;
+    constexpr FixedTrapezoid<int> small{ {0, 0}, {4, 0}, {3, 2}, {1, 2} };
+    static_assert(small.calcArea() == 6.0);
+    const FixedTrapezoid<int> fixed{ {s, 0}, {s + 2 * s, 0}, {s + s, s}, {s, s} };
+    const Trapezoid<int> fig = fixed.toFigure();
+    EXPECT_EQ(fixed.calcArea(), 1.5e10);
+    EXPECT_EQ(fixed.calcArea(), fig.calcArea());
+    EXPECT_EQ(fixed.calcGeometricCenter(), fig.calcGeometricCenter());
+    EXPECT_EQ(fig.calcGeometricCenter(), Point<int>(177777, 44444));
+}
+
+// --- Точная целочисленная арифметика ---
+
+TEST(ExactIntegerTest, RationalNormalizationAndRounding) {
+    EXPECT_EQ(ExactRational::make(6, -4), (ExactRational{-3, 2}));
+    EXPECT_EQ(ExactRational::make(0, 5), (ExactRational{0, 1}));
+    EXPECT_EQ(ExactRational::make(-3, 2).to<int>(), -2);
+    EXPECT_EQ(ExactRational::make(7, 3).to<int>(), 2);
+    EXPECT_EQ(ExactRational::make(8, 9).to<int>(), 1);
+    EXPECT_DOUBLE_EQ(ExactRational::make(1, 3).to<double>(), 1.0 / 3);
+}
+
+TEST(ExactIntegerTest, CenterIsExactRational) {
+    Trapezoid<int> t{ {0, 0}, {4, 0}, {3, 2}, {1, 2} };
+    auto c = t.calcGeometricCenterExact();
+    EXPECT_EQ(c.x, (ExactRational{2, 1}));
+    EXPECT_EQ(c.y, (ExactRational{8, 9}));
+    EXPECT_EQ(t.calcGeometricCenter(), Point<int>(2, 0));       // по-прежнему отбрасывает дробь
+    EXPECT_EQ(t.calcGeometricCenterAs<int>(), Point<int>(2, 1));
+    EXPECT_TRUE(PointsNear(t.calcGeometricCenterAs<double>(), Point<double>(2, 8.0 / 9), 1e-15));
+    EXPECT_EQ(t.calcDoubleAreaExact(), 12);
+
+    Pentagon<double> p{ {0, 0}, {2, 0}, {3, 1}, {1.5, 3}, {-0.5, 1} };
+    EXPECT_EQ(p.calcGeometricCenterAs<double>(), p.calcGeometricCenter());
+}
+
+TEST(ExactIntegerTest, LargeCoordinatesDoNotOverflow) {
+    // Произведения 32-битных координат не помещаются в int
+    const int big = 2'000'000'000;
+    Diamond<int> d{ {0, big}, {big, 0}, {0, -big}, {-big, 0} };
+    EXPECT_EQ(d.calcDoubleAreaExact(), -static_cast<ExactInt>(4) * big * big);
+    EXPECT_DOUBLE_EQ(d.calcArea(), 2.0 * big * big);
+
+    // Нанометры на масштабе в десятки километров: координаты около 2^45
+    const int64_t far = int64_t{1} << 45;
+    Trapezoid<int64_t> t{ {far, far}, {far + 4, far}, {far + 3, far + 2}, {far + 1, far + 2} };
+    EXPECT_EQ(t.calcDoubleAreaExact(), 12);
+    EXPECT_EQ(t.calcArea(), 6.0);
+
+    // Центр считается так же точно, как площадь
+    const int s = 100'000;
+    Trapezoid<int> wide{ {s, 0}, {3 * s, 0}, {2 * s, s}, {s, s} };
+    EXPECT_EQ(wide.calcGeometricCenter(), Point<int>(177777, 44444));
+    EXPECT_EQ(wide.calcGeometricCenterAs<int>(), Point<int>(177778, 44444));
+}
+
+TEST(ExactIntegerTest, BatchKernelMatchesFigure) {
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<int> dist(-(1 << 28), 1 << 28);
+    Figures<std::shared_ptr<Figure<int>>> figures;
+    for (int i = 0; i < 203; ++i) {
+        auto pt = [&] { return Point<int>(dist(gen), dist(gen)); };
+        if (i % 2 == 0)
+            figures.addFigure(std::make_shared<Trapezoid<int>>(std::initializer_list<Point<int>>{pt(), pt(), pt(), pt()}));
+        else
+            figures.addFigure(std::make_shared<Pentagon<int>>(
+                std::initializer_list<Point<int>>{pt(), pt(), pt(), pt(), pt()}));
+    }
+    FigureBatch<int> batch(figures);
+    auto exact = batch.doubleAreasExact();
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        EXPECT_EQ(static_cast<ExactInt>(exact[i]), figures[i]->calcDoubleAreaExact()) << i;
+    }
+}
+
+
+// --- Вычисления в float ---
+
+// Фигуры с размерами порядка единиц, сдвинутые далеко от начала координат
+static Figures<std::shared_ptr<Figure<float>>> makeFarFloatFigures(size_t n, float offset) {
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<float> pos(-offset, offset), size(0.5f, 8.0f);
+    Figures<std::shared_ptr<Figure<float>>> figures;
+    for (size_t i = 0; i < n; ++i) {
+        float x = pos(gen), y = pos(gen), r = size(gen);
+        if (i % 2 == 0)
+            figures.addFigure(std::make_shared<Diamond<float>>(std::initializer_list<Point<float>>{
+                {x, y + r}, {x + r, y}, {x, y - r}, {x - r, y}}));
+        else
+            figures.addFigure(std::make_shared<Pentagon<float>>(std::initializer_list<Point<float>>{
+                {x, y}, {x + r, y}, {x + 1.5f * r, y + r}, {x + r / 2, y + 2 * r}, {x - r / 2, y + r}}));
+    }
+    return figures;
+}
+
+TEST(FloatPathTest, ErrorIsBoundedAgainstDoublePath) {
+    const float offset = 1e4f;
+    auto figures = makeFarFloatFigures(501, offset);
+    FigureBatch<float> batch(figures);
+    auto areas = batch.areas();              // те же float-координаты, арифметика в double
+    auto centers = batch.centroids();
+    auto areasF = batch.areasFloat();
+    auto centersF = batch.centroidsFloat();
+
+    // Образец - те же float-координаты с арифметикой в double. Figure<float> для
+    // сравнения не годится: его произведения считаются в float от абсолютных
+    // координат и при сдвиге 1e4 теряют почти все значащие цифры.
+    const double eps = std::numeric_limits<float>::epsilon();
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        EXPECT_LE(std::abs(areasF[i] - areas[i]), 8 * eps * areas[i]) << i;
+        EXPECT_LE(std::abs(centersF[i][0] - centers[i][0]), 2 * offset * eps) << i;
+        EXPECT_LE(std::abs(centersF[i][1] - centers[i][1]), 2 * offset * eps) << i;
+    }
+}
+
+TEST(FloatPathTest, KernelsMatchScalarOnEveryIsa) {
+    auto figures = makeFarFloatFigures(203, 1e3f);
+    FigureBatch<float> batch(figures);
+    const auto view = batch.getPentagons().view();
+    const size_t n = view.size;
+    auto scalar = getFloatShoelaceKernels<5>(SimdIsa::Scalar);
+    std::vector<float> s(n), cx(n), cy(n), a(n);
+    scalar.doubleAreas(view.x.data(), view.y.data(), n, a.data());
+    scalar.centroids(view.x.data(), view.y.data(), n, s.data(), cx.data(), cy.data());
+    EXPECT_EQ(a, s);
+    for (SimdIsa isa : {SimdIsa::Sse2, SimdIsa::Avx2, SimdIsa::Avx512}) {
+        if (!isSimdIsaSupported(isa))
+            continue;
+        auto kernels = getFloatShoelaceKernels<5>(isa);
+        std::vector<float> s2(n), cx2(n), cy2(n), a2(n);
+        kernels.doubleAreas(view.x.data(), view.y.data(), n, a2.data());
+        kernels.centroids(view.x.data(), view.y.data(), n, s2.data(), cx2.data(), cy2.data());
+        EXPECT_EQ(a, a2) << "isa " << static_cast<int>(isa);
+        EXPECT_EQ(cx, cx2) << "isa " << static_cast<int>(isa);
+        EXPECT_EQ(cy, cy2) << "isa " << static_cast<int>(isa);
+    }
+}
+
+
+// --- Одновременное добавление и снимки ---
+
+// Квадрат площади 16, сдвинутый по x на id: по сдвигу восстанавливается порядок
+static std::shared_ptr<Figure<double>> makeTaggedSquare(size_t id) {
+    double d = static_cast<double>(id);
+    return std::make_shared<Diamond<double>>(std::initializer_list<Point<double>>{
+        {d, 2 * std::sqrt(2.0)}, {d + 2 * std::sqrt(2.0), 0}, {d, -2 * std::sqrt(2.0)}, {d - 2 * std::sqrt(2.0), 0}});
+}
+
+TEST(ConcurrentFiguresTest, FlushPublishesEverything) {
+    ConcurrentFigures<std::shared_ptr<Figure<double>>> figures({4, 8});
+    for (size_t i = 0; i < 21; ++i) {
+        figures.addFigure(std::make_shared<Trapezoid<double>>(Trapezoid<double>{{0, 0}, {8, 0}, {6, 4}, {2, 4}}));
+    }
+    EXPECT_EQ(figures.getPublishedSize(), 16u);    // два куска по 8, остальное ждёт публикации
+    figures.flush();
+    auto snapshot = figures.snapshot();
+    ASSERT_EQ(snapshot->getSize(), 21u);
+    EXPECT_DOUBLE_EQ(snapshot->calcTotalArea(), 21 * 24.0);
+    EXPECT_DOUBLE_EQ(snapshot->calcTotalArea({3, 5}), 21 * 24.0);
+
+    std::ostringstream expected, actual;
+    {
+        std::string buffer;
+        ReportWriter writer(expected, ReportFormat::Text, buffer, ReportArea);
+        for (size_t i = 0; i < snapshot->getSize(); ++i) {
+            writer.writeFigure(i, *(*snapshot)[i]);
+        }
+    }
+    {
+        std::string buffer;
+        ReportWriter writer(actual, ReportFormat::Text, buffer, ReportArea);
+        snapshot->writeReport(writer);
+    }
+    EXPECT_EQ(actual.str(), expected.str());
+}
+
+TEST(ConcurrentFiguresTest, SnapshotIsUnaffectedByLaterAppends) {
+    ConcurrentFigures<std::shared_ptr<Figure<double>>> figures({2, 1});
+    figures.addFigure(makeTaggedSquare(0));
+    auto before = figures.snapshot();
+    for (size_t i = 1; i < 100; ++i) {
+        figures.addFigure(makeTaggedSquare(i));
+    }
+    figures.flush();
+    EXPECT_EQ(before->getSize(), 1u);
+    EXPECT_NEAR(before->calcTotalArea(), 16.0, 1e-12);
+    EXPECT_EQ(figures.getPublishedSize(), 100u);
+}
+
+TEST(ConcurrentFiguresTest, UnpublishedLagIsBounded) {
+    // Без maxChunkSize порог рос бы как размер снимка / 16 (к концу - до 300)
+    ConcurrentFigures<std::shared_ptr<Figure<double>>> figures({4, 4, 16});
+    size_t maxLag = 0;
+    for (size_t i = 1; i <= 5000; ++i) {
+        figures.addFigure(makeTaggedSquare(i));
+        maxLag = std::max(maxLag, i - figures.getPublishedSize());
+    }
+    EXPECT_EQ(maxLag, 15u);
+    figures.flush();
+    EXPECT_EQ(figures.getPublishedSize(), 5000u);
+}
+
+// Запускать и под -DFIGURES_TSAN=ON
+TEST(ConcurrentFiguresTest, ProducersAndReadersStress) {
+    constexpr size_t producers = 8, readers = 3, perProducer = 3000;
+    ConcurrentFigures<std::shared_ptr<Figure<double>>> figures({4, 16});
+    std::atomic<bool> done{false};
+    std::atomic<size_t> failures{0};
+
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            size_t lastSize = 0;
+            while (!done.load()) {
+                auto snapshot = figures.snapshot();
+                size_t n = snapshot->getSize();
+                // Снимок согласован: размер не убывает, сумма соответствует размеру
+                if (n < lastSize || std::abs(snapshot->calcTotalArea({1, 512}) - 16.0 * n) > 1e-9 * (n + 1))
+                    failures++;
+                lastSize = n;
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (size_t p = 0; p < producers; ++p) {
+        writers.emplace_back([&, p] {
+            for (size_t i = 0; i < perProducer; ++i) {
+                figures.addFigure(makeTaggedSquare(p * perProducer + i));
+            }
+        });
+    }
+    for (auto &t : writers) {
+        t.join();
+    }
+    done = true;
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(failures.load(), 0u);
+
+    figures.flush();
+    auto snapshot = figures.snapshot();
+    ASSERT_EQ(snapshot->getSize(), producers * perProducer);
+    // Каждая фигура ровно один раз, порядок внутри производителя сохранён
+    std::vector<size_t> next(producers, 0);
+    std::vector<bool> seen(producers * perProducer, false);
+    snapshot->forEach(0, snapshot->getSize(), [&](size_t, const auto &fig) {
+        size_t id = static_cast<size_t>(std::lround(fig->calcGeometricCenter()[0]));
+        ASSERT_LT(id, seen.size());
+        EXPECT_FALSE(seen[id]);
+        seen[id] = true;
+        size_t p = id / perProducer;
+        EXPECT_GE(id % perProducer, next[p]);
+        next[p] = id % perProducer + 1;
+    });
+}
+
+
+// --- Версии с копированием при записи ---
+
+TEST(VersionedFiguresTest, FiguresCopyIsDeep) {
+    Figures<Trapezoid<double>> original;
+    original.addFigure(Trapezoid<double>{{0, 0}, {8, 0}, {6, 4}, {2, 4}});
+    original.addFigure(Trapezoid<double>{{0, 0}, {4, 0}, {3, 2}, {1, 2}});
+
+    Figures<Trapezoid<double>> copy(original);
+    copy[0] = Trapezoid<double>{{0, 0}, {2, 0}, {2, 2}, {0, 2}};
+    copy.addFigure(Trapezoid<double>{{0, 0}, {4, 0}, {3, 2}, {1, 2}});
+    copy.deleteFigure(1);
+    EXPECT_EQ(original.getSize(), 2u);
+    EXPECT_DOUBLE_EQ(original[0].calcArea(), 24.0);
+    EXPECT_DOUBLE_EQ(original[1].calcArea(), 6.0);
+    EXPECT_EQ(original.indexOf(original.handleAt(1)), 1u);
+
+    Figures<Trapezoid<double>> assigned;
+    assigned = original;
+    original.deleteFigure(0);
+    EXPECT_EQ(assigned.getSize(), 2u);
+    EXPECT_DOUBLE_EQ(assigned.calcTotalArea(), 30.0);
+    EXPECT_TRUE(assigned.contains(assigned.handleAt(0)));
+}
+
+// Случайные изменения, каждые несколько шагов снимок; все снимки сверяются с эталоном
+TEST(VersionedFiguresTest, SnapshotsMatchReferenceHistory) {
+    using Versions = VersionedFigures<Diamond<double>, 8>;
+    std::mt19937 gen(5);
+    Versions current;
+    std::vector<double> model;    // полудиагональ каждого ромба
+    std::vector<std::pair<Versions, std::vector<double>>> history;
+
+    auto diamond = [](double r) {
+        return Diamond<double>{{0, r}, {r, 0}, {0, -r}, {-r, 0}};
+    };
+    for (int step = 0; step < 2000; ++step) {
+        int op = std::uniform_int_distribution<int>(0, 9)(gen);
+        size_t n = model.size();
+        size_t index = n ? std::uniform_int_distribution<size_t>(0, n - 1)(gen) : 0;
+        double r = 1 + step % 17;
+        if (op < 5 || n == 0) {
+            current.addFigure(diamond(r));
+            model.push_back(r);
+        } else if (op < 7) {
+            current.setFigure(index, diamond(r));
+            model[index] = r;
+        } else if (op < 9) {
+            current.deleteFigure(index);
+            model.erase(model.begin() + index);
+        } else {
+            current.deleteFigureUnordered(index);
+            model[index] = model.back();
+            model.pop_back();
+        }
+        if (step % 50 == 0)
+            history.emplace_back(current.snapshot(), model);
+    }
+    history.emplace_back(current, model);
+
+    for (const auto &[version, expected] : history) {
+        ASSERT_EQ(version.getSize(), expected.size());
+        double total = 0;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_DOUBLE_EQ(version[i].calcArea(), 2 * expected[i] * expected[i]);
+            total += 2 * expected[i] * expected[i];
+        }
+        EXPECT_DOUBLE_EQ(version.calcTotalArea({3, 7}), total);
+    }
+}
+
+TEST(VersionedFiguresTest, MutationCopiesOnlyTouchedChunk) {
+    using Versions = VersionedFigures<std::shared_ptr<Figure<double>>, 64>;
+    Versions current;
+    for (size_t i = 0; i < 64 * 100; ++i) {
+        current.addFigure(makeTaggedSquare(i));
+    }
+    ASSERT_EQ(current.getChunkCount(), 100u);
+
+    Versions before;
+    {
+        AllocScope scope;
+        before = current.snapshot();
+        EXPECT_EQ(scope.getCount(), 0u);
+    }
+    {
+        AllocScope scope;
+        current.setFigure(64 * 42 + 5, makeTaggedSquare(0));
+        current.deleteFigure(64 * 7);
+        current.addFigure(makeTaggedSquare(1));
+        // Каталог копируется один раз, куски - по одному на изменение: намного
+        // меньше полной копии массива
+        EXPECT_LT(scope.getBytes(), 6400 * sizeof(std::shared_ptr<Figure<double>>) / 4);
+    }
+    // Последний кусок был полон, поэтому addFigure начал новый
+    EXPECT_EQ(before.countSharedChunks(current), 98u);
+    EXPECT_EQ(before.getSize(), 6400u);
+    EXPECT_EQ(current.getSize(), 6400u);
+    EXPECT_EQ(std::lround(before[64 * 42 + 5]->calcGeometricCenter()[0]), 64 * 42 + 5);
+    EXPECT_EQ(std::lround(before[64 * 7]->calcGeometricCenter()[0]), 64 * 7);
+    EXPECT_EQ(std::lround(current[64 * 7]->calcGeometricCenter()[0]), 64 * 7 + 1);
+}
+
+
+TEST(VersionedFiguresTest, SnapshotsReadFromManyThreads) {
+    VersionedFigures<Trapezoid<double>, 64> figures;
+    for (int i = 0; i < 1000; ++i) {
+        double d = i;
+        figures.addFigure(Trapezoid<double>{{d, 0}, {d + 8, 0}, {d + 6, 4}, {d + 2, 4}});
+    }
+    figures.setFigure(5, Trapezoid<double>{{0, 0}, {4, 0}, {3, 2}, {1, 2}});
+    // Две версии делят куски, то есть одни и те же фигуры
+    auto first = figures.snapshot(), second = figures.snapshot();
+    double totals[2] = {};
+    std::thread a([&] { totals[0] = first.calcTotalArea(ReduceOptions{1, 64}); });
+    std::thread b([&] { totals[1] = second.calcTotalArea(ReduceOptions{1, 64}); });
+    a.join();
+    b.join();
+    EXPECT_DOUBLE_EQ(totals[0], 999 * 24.0 + 6.0);
+    EXPECT_DOUBLE_EQ(totals[1], totals[0]);
+}
+
+// --- Проверка формы фигур ---
+
+TEST(ShapeValidationTest, AcceptsWellFormedFigures) {
+    ShapeValidationStats stats;
+    EXPECT_EQ(validateShape(Trapezoid<double>{{0, 0}, {8, 0}, {6, 4}, {2, 4}}, stats), 0);
+    EXPECT_EQ(validateShape(Diamond<double>{{0, 3}, {4, 0}, {0, -3}, {-4, 0}}, stats), 0);
+    EXPECT_EQ(validateShape(Pentagon<double>{{0, 0}, {4, 0}, {6, 2}, {3, 6}, {-2, 2}}, stats), 0);
+    EXPECT_EQ(validateShape(Trapezoid<int>{{0, 0}, {8, 0}, {6, 4}, {2, 4}}, stats), 0);
+    EXPECT_EQ(validateShape(Diamond<float>{{0, 3}, {4, 0}, {0, -3}, {-4, 0}}, stats), 0);
+    // Обход по часовой стрелке тоже допустим
+    EXPECT_EQ(validateShape(Pentagon<int>{{-2, 2}, {3, 6}, {6, 2}, {4, 0}, {0, 0}}, stats), 0);
+}
+
+TEST(ShapeValidationTest, ReportsReasonCodes) {
+    ShapeValidationStats stats;
+    EXPECT_EQ(validateShape(Trapezoid<double>{{0, 0}, {4, 0}, {5, 3}, {0, 2}}, stats), ShapeNoParallelSides);
+    // Параллелограмм - не ромб
+    EXPECT_EQ(validateShape(Diamond<double>{{0, 0}, {4, 0}, {5, 2}, {1, 2}}, stats), ShapeUnequalSides);
+    // Дельтоид: стороны попарно равны, но не параллельны
+    EXPECT_EQ(validateShape(Diamond<int>{{0, 3}, {2, 0}, {0, -6}, {-2, 0}}, stats) & ShapeNoParallelSides,
+              ShapeNoParallelSides);
+    // Бантик: основания параллельны, но стороны пересекаются
+    uint8_t bowtie = validateShape(Trapezoid<double>{{0, 0}, {4, 0}, {0, 4}, {4, 4}}, stats);
+    EXPECT_TRUE(bowtie & ShapeSelfIntersecting);
+    EXPECT_TRUE(bowtie & ShapeNotConvex);
+    EXPECT_FALSE(bowtie & ShapeNoParallelSides);
+    // Звезда: все повороты в одну сторону, но контур обходит центр дважды
+    EXPECT_EQ(validateShape(Pentagon<double>{{0, 10}, {6, -8}, {-10, 3}, {10, 3}, {-6, -8}}, stats),
+              ShapeSelfIntersecting);
+    EXPECT_EQ(validateShape(Pentagon<double>{{0, 0}, {4, 0}, {4, 4}, {2, 5}, {0, 4}}, stats) & ShapeNotConvex, 0);
+    EXPECT_EQ(validateShape(Pentagon<double>{{0, 0}, {2, 0}, {4, 0}, {3, 6}, {-2, 2}}, stats), ShapeCollinearCorner);
+    EXPECT_EQ(validateShape(Pentagon<int>{{0, 0}, {4, 0}, {2, 1}, {3, 6}, {-2, 2}}, stats), ShapeNotConvex);
+    uint8_t point = validateShape(Trapezoid<double>{{1, 1}, {1, 1}, {1, 1}, {1, 1}}, stats);
+    EXPECT_TRUE(point & ShapeRepeatedVertex);
+    EXPECT_TRUE(point & ShapeCollinearCorner);
+    EXPECT_EQ(validateShape(Trapezoid<double>{{0, 0}, {NAN, 0}, {6, 4}, {2, 4}}, stats), ShapeNonFinite);
+}
+
+// Знак ориентации на почти вырожденных тройках сверяется с целочисленным расчётом
+TEST(ShapeValidationTest, FilteredOrientationMatchesExact) {
+    std::mt19937_64 gen(11);
+    std::uniform_int_distribution<int64_t> coord(-(int64_t{1} << 30), int64_t{1} << 30);
+    std::uniform_int_distribution<int64_t> nudge(-1, 1);
+    const double unit = std::ldexp(1.0, -20);    // координаты кратны 2^-20, поэтому точны в double
+    ShapeValidationStats stats;
+    int mismatches = 0;
+    for (int iter = 0; iter < 20000; ++iter) {
+        int64_t ax = coord(gen), ay = coord(gen), bx = coord(gen), by = coord(gen);
+        int64_t k = std::uniform_int_distribution<int64_t>(-3, 3)(gen);
+        // c на прямой ab или рядом с ней (сдвиг на одну единицу сетки)
+        int64_t cx = ax + k * (bx - ax) + nudge(gen), cy = ay + k * (by - ay) + nudge(gen);
+        ExactInt exact = ExactInt(bx - ax) * (cy - ay) - ExactInt(by - ay) * (cx - ax);
+        int expected = (exact > 0) - (exact < 0);
+        std::array<DiffProduct<double>, 2> terms{{{bx * unit, ax * unit, cy * unit, ay * unit, 1},
+                                                 {by * unit, ay * unit, cx * unit, ax * unit, -1}}};
+        mismatches += sumSign(terms, stats) != expected;
+    }
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_GT(stats.exactPredicates, 0u);
+    EXPECT_GT(stats.filteredPredicates, 0u);
+}
+
+TEST(ShapeValidationTest, BatchBitmapMatchesPerFigureVerdicts) {
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    for (int i = 0; i < 1000; ++i) {
+        double d = i;
+        if (i % 3 == 0)
+            figures.addFigure(std::make_shared<Trapezoid<double>>(Trapezoid<double>{{d, 0}, {d + 8, 0}, {d + 6, 4}, {d + 2, 4}}));
+        else if (i % 3 == 1)
+            figures.addFigure(std::make_shared<Diamond<double>>(Diamond<double>{{d, 3}, {d + 4, 0}, {d, -3}, {d - 4 + (i % 7 == 1), 0}}));
+        else
+            figures.addFigure(std::make_shared<Pentagon<double>>(Pentagon<double>{{d, 0}, {d + 4, 0}, {d + 6, 2}, {d + 3, 6}, {d - 2, 2}}));
+    }
+    ShapeValidationResult result = validateShapes(figures, {4, 100});
+    ASSERT_EQ(result.getSize(), 1000u);
+    size_t expectedValid = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+        ShapeValidationStats stats;
+        uint8_t defects = validateShape(*figures[i], stats);
+        EXPECT_EQ(result.getDefects(i), defects);
+        EXPECT_EQ(result.isValid(i), defects == 0);
+        EXPECT_EQ(defects == 0, !(i % 3 == 1 && i % 7 == 1)) << i;
+        expectedValid += defects == 0;
+    }
+    EXPECT_EQ(result.countValid(), expectedValid);
+    EXPECT_EQ(result.invalidFigures().size(), 1000 - expectedValid);
+
+    ShapeValidationResult single = validateShapes(figures, {1, 1});
+    EXPECT_TRUE(std::equal(single.getValidBits().begin(), single.getValidBits().end(),
+                           result.getValidBits().begin(), result.getValidBits().end()));
+    EXPECT_EQ(single.getStats().exactPredicates, result.getStats().exactPredicates);
+}
+
+// --- Сводка по коллекции ---
+
+// Та же сводка, посчитанная заново обходом всех фигур
+template<class U>
+static FigureAggregates recomputeAggregates(const Figures<U> &figures) {
+    FigureAggregates result;
+    result.count = figures.getSize();
+    double wx = 0, wy = 0;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        const auto &fig = Figures<U>::deref(figures[i]);
+        const double area = fig.calcArea();
+        result.kindCounts[static_cast<size_t>(fig.getKind())]++;
+        result.totalArea += area;
+        if (area > 0) {
+            auto center = fig.template calcGeometricCenterAs<double>();
+            wx += area * center[0];
+            wy += area * center[1];
+        }
+        result.minArea = i == 0 ? area : std::min(result.minArea, area);
+        result.maxArea = i == 0 ? area : std::max(result.maxArea, area);
+    }
+    if (result.totalArea > 0)
+        result.centroid = Point<double>(wx / result.totalArea, wy / result.totalArea);
+    return result;
+}
+
+template<class U>
+static void expectAggregatesMatch(const Figures<U> &figures) {
+    const FigureAggregates expected = recomputeAggregates(figures);
+    const FigureAggregates actual = figures.getAggregates();
+    EXPECT_EQ(actual.count, expected.count);
+    EXPECT_EQ(actual.kindCounts, expected.kindCounts);
+    EXPECT_NEAR(actual.totalArea, expected.totalArea, 1e-9 * (1 + expected.totalArea));
+    EXPECT_NEAR(actual.centroid[0], expected.centroid[0], 1e-9);
+    EXPECT_NEAR(actual.centroid[1], expected.centroid[1], 1e-9);
+    EXPECT_EQ(actual.minArea, expected.minArea);
+    EXPECT_EQ(actual.maxArea, expected.maxArea);
+    EXPECT_EQ(figures.getTotalArea(), actual.totalArea);
+}
+
+TEST(FigureAggregatesTest, TracksAddAndDelete) {
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    EXPECT_EQ(figures.getAggregates().count, 0u);
+    EXPECT_EQ(figures.getAggregates().minArea, 0.0);
+    EXPECT_EQ(figures.getTotalArea(), 0.0);
+
+    // Площади 24, 24 и 16: центр масс - среднее центров с весами
+    figures.addFigure(std::make_shared<Trapezoid<double>>(Trapezoid<double>{{0, 0}, {8, 0}, {6, 4}, {2, 4}}));
+    figures.addFigure(std::make_shared<Diamond<double>>(Diamond<double>{{10, 3}, {14, 0}, {10, -3}, {6, 0}}));
+    figures.addFigure(makeTaggedSquare(20));
+    const FigureAggregates &agg = figures.getAggregates();
+    EXPECT_EQ(agg.count, 3u);
+    EXPECT_EQ(agg.kindCounts[static_cast<size_t>(FigureKind::Trapezoid)], 1u);
+    EXPECT_EQ(agg.kindCounts[static_cast<size_t>(FigureKind::Diamond)], 2u);
+    EXPECT_NEAR(agg.totalArea, 64.0, 1e-12);
+    EXPECT_EQ(agg.minArea, 16.0);
+    EXPECT_EQ(agg.maxArea, 24.0);
+    const double centerY = 24.0 * figures[0]->calcGeometricCenter()[1] / 64.0;
+    EXPECT_NEAR(agg.centroid[0], (24.0 * 4 + 24.0 * 10 + 16.0 * 20) / 64.0, 1e-12);
+    EXPECT_NEAR(agg.centroid[1], centerY, 1e-12);
+
+    figures.deleteFigureUnordered(2);
+    EXPECT_EQ(figures.getAggregates().minArea, 24.0);
+    EXPECT_NEAR(figures.getTotalArea(), 48.0, 1e-12);
+    figures.deleteFigure(0);
+    expectAggregatesMatch(figures);
+    figures.deleteFigure(0);
+    EXPECT_EQ(figures.getAggregates().count, 0u);
+    EXPECT_EQ(figures.getAggregates().maxArea, 0.0);
+    EXPECT_EQ(figures.getTotalArea(), 0.0);
+}
+
+TEST(FigureAggregatesTest, MatchesRecomputationUnderRandomEdits) {
+    std::mt19937 rng(25);
+    std::uniform_real_distribution<double> coord(-100, 100), size(0.5, 10);
+    auto randomFigure = [&]() -> std::shared_ptr<Figure<double>> {
+        const double x = coord(rng), y = coord(rng), s = size(rng);
+        switch (rng() % 3) {
+        case 0:
+            return std::make_shared<Trapezoid<double>>(
+                Trapezoid<double>{{x, y}, {x + 2 * s, y}, {x + 1.5 * s, y + s}, {x + 0.5 * s, y + s}});
+        case 1:
+            return std::make_shared<Diamond<double>>(Diamond<double>{{x, y + s}, {x + s, y}, {x, y - s}, {x - s, y}});
+        default:
+            return std::make_shared<Pentagon<double>>(
+                Pentagon<double>{{x, y}, {x + s, y}, {x + 1.5 * s, y + s}, {x + 0.5 * s, y + 2 * s}, {x - 0.5 * s, y + s}});
+        }
+    };
+
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    std::vector<FigureHandle> handles;
+    for (int step = 0; step < 2000; ++step) {
+        const unsigned op = rng() % 8;
+        if (figures.getSize() == 0 || op < 4) {
+            handles.push_back(figures.insertFigure(randomFigure()));
+        } else if (op == 4) {
+            figures.deleteFigureUnordered(rng() % figures.getSize());
+        } else if (op == 5) {
+            figures.deleteFigure(rng() % figures.getSize());
+        } else if (op == 6) {
+            figures.eraseFigure(handles[rng() % handles.size()]);
+        } else {
+            figures.modifyFigure(rng() % figures.getSize(), [&](auto &fig) { fig = randomFigure(); });
+        }
+        if (step % 97 == 0)
+            expectAggregatesMatch(figures);
+    }
+    expectAggregatesMatch(figures);
+}
+
+TEST(FigureAggregatesTest, ModifyFigureUpdatesInPlace) {
+    Figures<Trapezoid<double>> figures;
+    for (int i = 0; i < 10; ++i) {
+        double d = i;
+        figures.addFigure(Trapezoid<double>{{d, 0}, {d + 8, 0}, {d + 6, 4}, {d + 2, 4}});
+    }
+    EXPECT_NEAR(figures.getTotalArea(), 240.0, 1e-9);
+    // Растянуть одну фигуру вдвое по y: площадь 48
+    figures.modifyFigure(3, [](Trapezoid<double> &fig) { fig.transform(Affine2::scaling(1, 2)); });
+    EXPECT_NEAR(figures.getTotalArea(), 264.0, 1e-9);
+    EXPECT_EQ(figures.getAggregates().maxArea, 48.0);
+    expectAggregatesMatch(figures);
+}
+
+TEST(FigureAggregatesTest, MutableAccessMarksAggregatesStale) {
+    Figures<Trapezoid<double>> figures;
+    figures.addFigure(Trapezoid<double>{{0, 0}, {8, 0}, {6, 4}, {2, 4}});
+    figures.addFigure(Trapezoid<double>{{0, 0}, {4, 0}, {3, 2}, {1, 2}});
+    EXPECT_NEAR(figures.getTotalArea(), 30.0, 1e-12);
+
+    figures[1].transform(Affine2::scaling(2, 2));
+    expectAggregatesMatch(figures);
+    EXPECT_NEAR(figures.getTotalArea(), 48.0, 1e-12);
+
+    figures.transform(Affine2::translation(5, 5));
+    for (auto &fig : figures) {
+        fig.transform(Affine2::scaling(0.5, 1));
+    }
+    expectAggregatesMatch(figures);
+
+    // Изменение через указатель, которого Figures не видит, - явный пересчёт
+    Figures<std::shared_ptr<Figure<double>>> shared;
+    shared.addFigure(makeTaggedSquare(0));
+    const auto &view = shared;
+    view[0]->transform(Affine2::scaling(3, 1));
+    EXPECT_NEAR(shared.getTotalArea(), 16.0, 1e-12);
+    shared.refreshAggregates();
+    EXPECT_NEAR(shared.getTotalArea(), 48.0, 1e-12);
+}
+
+TEST(FigureAggregatesTest, PointerMutationDoesNotDriftTotal) {
+    // Фигуры меняют через свои указатели, как в main.cpp
+    auto small = makeTaggedSquare(0);
+    auto large = std::make_shared<Diamond<double>>(Diamond<double>{{0, 4}, {4, 0}, {0, -4}, {-4, 0}});
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    figures.addFigure(small);
+    figures.addFigure(large);
+    small->transform(Affine2::scaling(0.5, 0.5));
+    // Вычитается то, что было добавлено, а не текущая площадь фигуры
+    figures.deleteFigure(0);
+    EXPECT_NEAR(figures.getTotalArea(), 32.0, 1e-12);
+    EXPECT_EQ(figures.getAggregates().minArea, 32.0);
+    expectAggregatesMatch(figures);
+}
+
+TEST(FigureAggregatesTest, CapacityNotPowerOfTwo) {
+    const Diamond<double> unit{{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+    const Diamond<double> big{{0, 10}, {10, 0}, {0, -10}, {-10, 0}};
+    for (size_t n : {3, 6, 10, 17, 1000}) {
+        Figures<Diamond<double>> figures(n);
+        for (size_t i = 0; i < n; ++i) {
+            figures.addFigure(unit);
+        }
+        figures[n - 1] = big;
+        EXPECT_EQ(figures.getAggregates().maxArea, 200.0) << n;
+        figures.refreshAggregates();
+        EXPECT_EQ(figures.getAggregates().maxArea, 200.0) << n;
+        EXPECT_EQ(figures.getAggregates().minArea, 2.0) << n;
+
+        figures.modifyFigure(0, [&](auto &fig) { fig = big; });
+        figures.deleteFigure(static_cast<int>(n - 1));
+        EXPECT_EQ(figures.getAggregates().maxArea, 200.0) << n;
+        figures.deleteFigure(0);
+        EXPECT_EQ(figures.getAggregates().maxArea, n > 2 ? 2.0 : 0.0) << n;
+        expectAggregatesMatch(figures);
+    }
+}
+
+TEST(FigureAggregatesTest, ConstReadsFromManyThreads) {
+    Figures<Trapezoid<double>> figures;
+    for (int i = 0; i < 1000; ++i) {
+        double d = i;
+        figures.addFigure(Trapezoid<double>{{d, 0}, {d + 8, 0}, {d + 6, 4}, {d + 2, 4}});
+    }
+    // Устаревшая сводка: чтения считают её обходом, который прогревает кэши
+    // фигур, поэтому изменённую фигуру прогревают заранее
+    figures[0] = Trapezoid<double>{{0, 0}, {4, 0}, {3, 2}, {1, 2}};
+    figures[0].warmCache();
+    const auto &view = figures;
+    std::vector<std::thread> readers;
+    std::vector<double> totals(4);
+    for (size_t t = 0; t < totals.size(); ++t) {
+        readers.emplace_back([&, t] { totals[t] = view.getAggregates().totalArea; });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    for (double total : totals) {
+        EXPECT_NEAR(total, 999 * 24.0 + 6.0, 1e-9);
+    }
+}
+
+TEST(FigureAggregatesTest, MutableAccessAfterInsertStaysIncremental) {
+    // Добавление и сразу неконстантное чтение, как в IndexedFigures: пересчёт
+    // только тронутых позиций, а не всей сводки на каждом добавлении
+    constexpr size_t n = 2000;
+    auto &stats = Figure<double>::cacheStats();
+    for (int mode = 0; mode < 3; ++mode) {
+        Figures<std::shared_ptr<Figure<double>>> figures;
+        stats = {};
+        for (size_t i = 0; i < n; ++i) {
+            figures.addFigure(makeTaggedSquare(i));
+            if (mode == 0)
+                figures[i]->calcBoundingBox();
+            else if (mode == 1)
+                figures.get(figures.handleAt(i));
+            else
+                figures.begin();
+        }
+        EXPECT_LT(stats.hits + stats.misses, 20 * n) << mode;
+        figures.addFigure(makeTaggedSquare(n));
+        expectAggregatesMatch(figures);
+    }
+}
+
+TEST(FigureAggregatesTest, ReplacedThroughMutableAccess) {
+    Figures<std::shared_ptr<Figure<double>>> figures;
+    figures.addFigure(makeTaggedSquare(0));
+    figures.addFigure(makeTaggedSquare(1));
+    // Позиция тронута дважды: вклад снимается с видом, под которым был учтён
+    figures[0] = std::make_shared<Trapezoid<double>>(Trapezoid<double>{{0, 0}, {4, 0}, {3, 2}, {1, 2}});
+    figures[0] = std::make_shared<Pentagon<double>>(Pentagon<double>{{0, 0}, {2, 0}, {3, 1}, {1.5, 3}, {-0.5, 1}});
+    figures.addFigure(makeTaggedSquare(2));
+    auto aggregates = figures.getAggregates();
+    EXPECT_EQ(aggregates.kindCounts[static_cast<size_t>(FigureKind::Diamond)], 2u);
+    EXPECT_EQ(aggregates.kindCounts[static_cast<size_t>(FigureKind::Pentagon)], 1u);
+    EXPECT_EQ(aggregates.kindCounts[static_cast<size_t>(FigureKind::Trapezoid)], 0u);
+    EXPECT_NEAR(aggregates.totalArea, 32.0 + 6.25, 1e-12);
+    expectAggregatesMatch(figures);
+}
+
+TEST(FigureAggregatesTest, DegenerateFiguresHaveZeroWeight) {
+    Figures<Diamond<double>> figures;
+    figures.addFigure(Diamond<double>{{0, 0}, {0, 0}, {0, 0}, {0, 0}});
+    EXPECT_EQ(figures.getAggregates().minArea, 0.0);
+    EXPECT_EQ(figures.getAggregates().centroid, Point<double>());
+    figures.addFigure(Diamond<double>{{10, 3}, {14, 0}, {10, -3}, {6, 0}});
+    EXPECT_EQ(figures.getAggregates().centroid, Point<double>(10, 0));
+    EXPECT_EQ(figures.getAggregates().minArea, 0.0);
+    EXPECT_EQ(figures.getAggregates().maxArea, 24.0);
+    expectAggregatesMatch(figures);
+}
+
+TEST(FigureAggregatesTest, CopyKeepsAggregates) {
+    Figures<Pentagon<int>> figures;
+    for (int i = 0; i < 5; ++i) {
+        figures.addFigure(Pentagon<int>{{0, 0}, {4 + i, 0}, {6 + i, 2}, {3, 6}, {-2, 2}});
+    }
+    Figures<Pentagon<int>> copy(figures);
+    copy.deleteFigureUnordered(0);
+    expectAggregatesMatch(figures);
+    expectAggregatesMatch(copy);
+}